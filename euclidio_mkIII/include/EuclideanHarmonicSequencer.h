@@ -28,6 +28,8 @@ public:
   // Reset all per-track parameters to defaults (stops playback)
   void resetToDefaults();
   void update(); // deve ser chamada no loop()
+  // Song Position Pointer: recalcula passo e posição na lista de acordes por track
+  void relocate(uint32_t tick);
 
   // Parâmetros simples (operam sobre a track ativa)
   void setSteps(uint8_t steps);
@@ -60,6 +62,19 @@ public:
   uint8_t getVelocity() const { return velocity[activeTrack]; }
   void setNoteLength(uint16_t ms) { noteLength[activeTrack] = ms; }
   uint16_t getNoteLength() const { return noteLength[activeTrack]; }
+  // Output ports for the active track (EuclideanSequencer::OutputPort bitmask)
+  void setOutputPorts(uint8_t ports) { outputPorts[activeTrack] = ports & EuclideanSequencer::PORT_ALL; }
+  uint8_t getOutputPorts() const { return outputPorts[activeTrack]; }
+  uint8_t getOutputPortsForTrack(uint8_t t) const { return (t < MAX_TRACKS) ? outputPorts[t] : EuclideanSequencer::PORT_ALL; }
+  // Gate length mode for the active track (EuclideanSequencer::GateMode): fixed ms
+  // (noteLength), 24 PPQN ticks (1-96) or percent of the step (1-100)
+  void setGateMode(uint8_t mode);
+  uint8_t getGateMode() const { return gateMode[activeTrack]; }
+  void setGateAmount(uint8_t amount);
+  uint8_t getGateAmount() const { return gateAmount[activeTrack]; }
+  // Hit distribution algorithm for the active track (EuclideanPatterns::Algorithm)
+  void setAlgorithm(uint8_t algo);
+  uint8_t getAlgorithm() const { return algorithm[activeTrack]; }
   void setDistributionMode(int m) { distributionMode[activeTrack] = (DistributionMode)m; }
   int getDistributionMode() const { return (int)distributionMode[activeTrack]; }
   // UI-visible Active flag (separate from internal playback `enabled`)
@@ -145,31 +160,31 @@ private:
   std::array<DistributionMode, MAX_TRACKS> distributionMode;
   std::array<int, MAX_TRACKS> scaleType; // current ScaleType (stored as int)
   std::array<uint8_t, MAX_TRACKS> resolutionIndex; // 0:1/4, 1:1/8, 2:1/16
+  std::array<uint8_t, MAX_TRACKS> outputPorts; // EuclideanSequencer::OutputPort bitmask
+  std::array<uint8_t, MAX_TRACKS> gateMode; // EuclideanSequencer::GateMode
+  std::array<uint8_t, MAX_TRACKS> gateAmount; // ticks or percent, depending on gateMode
+  std::array<uint8_t, MAX_TRACKS> algorithm; // EuclideanPatterns::Algorithm
 
   // Runtime
   bool running;
   uint8_t currentStep;
   uint8_t lastStep;
   std::array<uint8_t, MAX_TRACKS> currentStepPerTrack; // per-track current step for UI
+  std::array<uint8_t, MAX_TRACKS> lastStepPerTrack; // last step triggered per track (255 = none)
   std::array<bool, MAX_TRACKS> enabled; // per-track enabled/disabled
   std::array<bool, MAX_TRACKS> uiActive; // per-track UI Active flag (starts false)
   // Per-track patterns and chord lists (static buffers to avoid dynamic allocs)
-  static const uint8_t MAX_STEPS = 32;
+  static const uint8_t MAX_STEPS = EuclideanPatterns::MAX_STEPS;
   static const uint8_t MAX_CHORDS = 16;
   bool pattern[MAX_TRACKS][MAX_STEPS];
   uint8_t patternLen[MAX_TRACKS];
+  uint8_t hitsBefore[MAX_TRACKS][MAX_STEPS + 1]; // hits in steps [0, i): chord position on relocate
   uint8_t activeTrack = 0; // internal 0-based active track index
   // Content: list of scale degrees to be used as chords (0..6) per track
   uint8_t chordList[MAX_TRACKS][MAX_CHORDS];
   uint8_t chordListSize[MAX_TRACKS];
   std::array<uint8_t, MAX_TRACKS> chordListPos; // position/index into chordList for next hit per track
 
-  // Pending note-offs gerenciados localmente (note + channel + time)
-  struct PendingOff { uint8_t note; uint8_t channel; uint32_t time; };
-  static const uint8_t MAX_PENDING_OFFS = 64;
-  PendingOff pendingOffs[MAX_PENDING_OFFS];
-  uint8_t pendingOffsCount;
-
   // Request deferred forced feedback to be sent from `update()` context
   bool pendingFeedback;
 
@@ -184,10 +199,13 @@ private:
   // Helpers
   void generatePattern();
   void generatePatternForTrack(uint8_t t);
-  // Allocation-free bjorklund variant: fills a preallocated buffer `out` with 0/1 values.
-  void bjorklundAlgorithm(std::vector<bool> &outPattern, uint8_t steps, uint8_t hits, uint8_t off);
-  void bjorklundStatic(bool *out, uint8_t steps, uint8_t hits, uint8_t off, uint8_t max_len);
+  // Allocation-free bjorklund: fills a preallocated buffer `out` with 0/1 values
+  // from the compile-time pattern table (see EuclideanPatterns).
+  void bjorklundStatic(bool *out, uint8_t steps, uint8_t hits, uint8_t off, uint8_t max_len,
+                       uint8_t algo = EuclideanPatterns::ALGO_ANCHORED);
   void triggerChord(uint8_t degreeIndex);
+  // PPQN ticks per step of track `t` (shared table in EuclideanMidiEngine)
+  uint16_t ticksPerStepForTrack(uint8_t t) const;
   // Deferred pattern generation to avoid blocking during rapid encoder edits
   static const unsigned long PATTERN_DEBOUNCE_MS = 120;
   // flags used internally to defer pattern regeneration
@@ -4,9 +4,11 @@
 #include <Arduino.h>
 #include "EuclideanSequencer.h"
 #include "MidiClock.h"
+#include "TimingWheel.h"
+#include "MpscQueue.h"
+#include <atomic>
 // FreeRTOS primitives
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 #include <freertos/task.h>
 
 class Adafruit_USBD_MIDI;
@@ -14,6 +16,43 @@ class OSCController;
 class MIDIRouter;
 
 class EuclideanMidiEngine {
+public:
+	// Nota redisparada antes do Note Off anterior: Note Off e novo Note On, ou
+	// fundida com a que já soa (sem novo Note On). O Note Off sai com o último.
+	enum RetriggerMode : uint8_t {
+		RETRIGGER_OFF_FIRST = 0,
+		RETRIGGER_MERGE
+	};
+
+	// Origem de uma nota
+	enum NoteSource : uint8_t {
+		SOURCE_EUCLIDEAN = 0,
+		SOURCE_HARMONIC,
+		SOURCE_EXTERNAL,     // onSendMidi: sem track; gate da track do canal ou EXTERNAL_GATE_MS
+		NUM_SOURCES
+	};
+	static const uint8_t MAX_EVENT_TRACKS = 64;   // cabe no payload da roda (6 bits)
+	static const uint16_t EXTERNAL_GATE_MS = 100;  // gate de onSendMidi sem track no canal
+
+	// Tabela de ticks por resolução: índice 0-3 para resolution 1-4 (1/4..1/32),
+	// partilhada pelos dois sequenciadores
+	static const uint8_t ticksPerResolution[4];
+
+	// Nota de um sequenciador, da criação à saída: a track, a origem, o instante
+	// e o gate viajam com o evento (o Note Off agendado também os leva), sem
+	// pesquisas por canal no caminho.
+	struct NoteEvent {
+		uint32_t timestampUs;   // micros() em que a nota foi criada
+		uint32_t gateUs;        // Note On: duração até ao Note Off (0 = sem Note Off agendado)
+		uint8_t channel;
+		uint8_t note;
+		uint8_t velocity;
+		uint8_t ports;          // portas de destino (EuclideanSequencer::OutputPort)
+		uint8_t track;          // índice da track na sua origem
+		uint8_t source;         // NoteSource
+		bool isNoteOn;
+	};
+
 private:
 	EuclideanSequencer* euclSeq = nullptr;
 	MidiClock* clock = nullptr;
@@ -21,48 +60,141 @@ private:
 	OSCController* osc = nullptr;
 	
 	unsigned long lastBpmUpdateTime = 0;
+
 	
-	// Tabela de ticks por resolução: índice 0-3 para resolution 1-4
-	static const uint8_t ticksPerResolution[4];
-	
-	// Fila unificada para USB MIDI (não-bloqueante)
-	static const uint16_t MIDI_QUEUE_SIZE = 512;  // Aumentado para evitar overflow
-	struct MidiEvent {
-		uint8_t channel;
-		uint8_t note;
-		uint8_t velocity;
-		uint16_t noteLength;  // Duração da nota em ms
-		bool isNoteOn;
-		// Se precisar diferenciar: podem ser enviados para ambos
-	};
-	MidiEvent midiQueue[MIDI_QUEUE_SIZE];
-	volatile uint16_t midiQueueHead = 0;
-	volatile uint16_t midiQueueTail = 0;
-	volatile uint32_t midiDroppedEvents = 0;
+	// Fila unificada para USB MIDI (não-bloqueante, vários produtores: clock task,
+	// loop, harmónico e o próprio worker com os Note Offs)
+	static const uint16_t MIDI_QUEUE_SIZE = 512;  // Aumentado para evitar overflow (potência de 2)
+	MpscQueue<NoteEvent, MIDI_QUEUE_SIZE> midiQueue;
+	std::atomic<uint32_t> midiDroppedEvents{0};
 
-	// Worker task and semaphore para processar a fila sem bloquear o loop principal
+	// Worker task para processar a fila sem bloquear o loop principal. Os
+	// produtores só o notificam quando está a dormir (acordar em lote).
 	TaskHandle_t midiWorkerHandle = nullptr;
-	SemaphoreHandle_t midiQueueSem = nullptr;
+	std::atomic<bool> workerWaiting{false};
+	RetriggerMode retriggerMode = RETRIGGER_OFF_FIRST;
 	
 	// Helpers para a fila (privadas)
-	void enqueueMidiEvent(uint8_t channel, uint8_t note, uint8_t velocity, uint16_t noteLength, bool isNoteOn);
+	void enqueueMidiEvent(const NoteEvent& evt);
+	
+	// Agenda o Note Off de `on` para daqui a on.gateUs (resolução de 250µs),
+	// com a mesma track, origem e portas do Note On
+	bool scheduleNoteOff(const NoteEvent& on);
+	// Note Off <-> payload de 32 bits da roda: canal 4 | nota 7 | velocity 7 |
+	// portas 5 | track 6 | origem 2
+	static uint32_t packNoteOff(const NoteEvent& on);
+	static void unpackNoteOff(uint32_t payload, NoteEvent& off);
+	
+	// Estatísticas por origem e track (worker): Note Ons enviados e maior
+	// atraso entre a criação da nota e a entrega às saídas
+	static const uint8_t STATS_TRACKS = EuclideanSequencer::MAX_TRACKS;
+	uint32_t trackNoteCount[NUM_SOURCES][STATS_TRACKS] = {};
+	uint32_t trackMaxLatencyUs[NUM_SOURCES][STATS_TRACKS] = {};
+
+	// Acorda o worker se estiver a dormir
+	void wakeWorker();
 
 	// Task do worker que consome a fila
 	static void midiWorkerTask(void* pvParameters);
 	
-	// Para agendar Note Offs (uma fila por track para polifonia)
-	struct PendingNoteOff {
-		bool pending;
-		uint8_t note;
+	// Vozes ativas por porta de saída (só o worker lhes toca): contagem de
+	// disparos por (canal, nota) e bitset das notas ativas, para que um Note Off
+	// só saia quando a última nota sobreposta termina e para silenciar tudo em
+	// O(notas ativas).
+	static const uint8_t VOICE_PORTS = 4;   // 0-2 = DIN1-3, 3 = USB
+	struct VoiceTable {
+		uint8_t refs[16][128];
+		uint32_t active[16][4];    // bit por nota com refs > 0
+		uint16_t activeChannels;   // bit por canal com alguma nota ativa
+	};
+	VoiceTable voices[VOICE_PORTS] = {};
+	uint16_t activeVoices = 0;
+	uint32_t voiceRetriggers = 0;
+	uint32_t voiceSuppressedOffs = 0;
+	std::atomic<uint8_t> voiceFlushRequest{0};   // portas (OutputPort) a silenciar
+	uint8_t lastOutputNotes = EuclideanSequencer::OUT_ALL;
+	
+	static uint8_t voicePortBit(uint8_t slot) { return slot < 3 ? (uint8_t)(1 << slot) : (uint8_t)EuclideanSequencer::PORT_USB; }
+	void sendToVoicePort(uint8_t slot, uint8_t status, uint8_t data1, uint8_t data2);
+	void voiceNoteOn(uint8_t slot, uint8_t channel, uint8_t note, uint8_t velocity);
+	void voiceNoteOff(uint8_t slot, uint8_t channel, uint8_t note, uint8_t velocity);
+	// Envia Note Off de todas as vozes ativas nas portas de `ports` (worker)
+	void flushVoices(uint8_t ports);
+	
+	// Note Offs de ambos os sequenciadores numa única roda temporal
+	// (agendados na task do clock, expirados pelo worker)
+	TimingWheel noteOffWheel;
+	portMUX_TYPE noteOffMux = portMUX_INITIALIZER_UNLOCKED;
+	static const uint8_t NOTE_OFF_BATCH = 32;
+	// Gates no domínio do clock: mínimo e folga antes do step seguinte, para que o
+	// Note Off (worker, resolução de 1 tick RTOS + 250µs) saia antes do próximo Note On
+	static const uint32_t GATE_MIN_US = 1000;
+	static const uint32_t GATE_GUARD_US = 2000;
+	
+	// Expira Note Offs vencidos e enfileira-os (contexto do worker)
+	void processNoteOffs();
+	
+	// Render antecipado: as notas dos próximos LOOKAHEAD_US são calculadas à
+	// frente (fora do instante do tick) para um buffer por track, carimbadas com
+	// a posição 960 PPQN em que tocam. No tick só se emitem as já vencidas.
+	// Todo o estado é da task do clock; as edições chegam pela geração de
+	// edição da track e invalidam apenas o que essa track ainda não emitiu.
+	static const uint32_t LOOKAHEAD_US = 50000;
+	static const uint8_t MAX_LOOKAHEAD_TICKS = 24;
+	static const uint8_t RENDER_SLOTS = 16;    // potência de 2
+	struct RenderedNote {
+		uint32_t position;    // posição 960 PPQN da nota
 		uint8_t channel;
-		uint8_t velocity;  // Velocity para NOTE OFF
-		uint16_t noteLength;  // Duração da nota em ms
-		uint32_t time;
+		uint8_t note;
+		uint8_t velocity;
+		uint16_t lengthMs;
+		uint8_t ports;
+		uint8_t gateMode;     // EuclideanSequencer::GateMode
+		uint8_t gateAmount;
+		uint8_t stepTicks;    // ticks de 24 PPQN por step da track
+		uint8_t ratchet;      // notas do step (o gate de cada uma é a sua fração)
 	};
-	PendingNoteOff pendingNoteOffs[8];  // Uma entrada por track
+	struct TrackRender {
+		RenderedNote events[RENDER_SLOTS];
+		uint8_t head = 0;             // próximo slot livre
+		uint8_t tail = 0;             // próxima nota a emitir
+		uint32_t renderedUpTo = 0;    // primeiro tick ainda não renderizado
+		uint8_t editGen = 0;          // geração de edição usada no render
+		uint32_t rng = 1;             // xorshift32 da probabilidade (nunca 0)
+	};
+	TrackRender trackRender[EuclideanSequencer::MAX_TRACKS];
+	// Tracks com notas renderizadas por emitir: o tick só percorre estas e as que tocam
+	EuclideanSequencer::TrackMask renderPending = 0;
+	static_assert(EuclideanSequencer::MAX_TRACKS <= MAX_EVENT_TRACKS, "tracks a mais para o payload dos Note Off");
+	static_assert(EuclideanSequencer::MAX_RATCHET <= RENDER_SLOTS, "um step com ratchet tem de caber no buffer");
 	
-	// Rastreia o último step euclidiano processado para cada track
-	uint8_t lastProcessedStep[8] = {0};  // Uma entrada por track
+	// Probabilidade: um xorshift32 por track, semeado em resetRender a partir da
+	// semente do sequenciador e da track. Só é sorteado nos hits sujeitos a
+	// probabilidade < 100 %, por isso um padrão sem probabilidade não o consome.
+	static uint32_t nextRandom(uint32_t& state) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+	// Verdadeiro com `percent` % de probabilidade (16 bits altos escalados a 0..99)
+	static bool chance(uint32_t& state, uint8_t percent) {
+		return (((nextRandom(state) >> 16) * 100u) >> 16) < percent;
+	}
+	// Ratchets fora das fronteiras de tick: agenda no clock as posições 960 PPQN
+	// em (fromPos, toPos] para que saiam no instante exato e não no tick seguinte
+	void scheduleSubtickNotes(uint32_t fromPos, uint32_t toPos);
+	
+	// Descarta o render de todas as tracks e recomeça a renderizar em `tick`
+	void resetRender(uint32_t tick);
+	// Ticks de render à frente (LOOKAHEAD_US ao período de tick atual)
+	uint32_t lookaheadTicks() const;
+	// Renderiza a track até ao tick `untilTick` (inclusive)
+	void renderTrack(uint8_t trackIdx, uint32_t untilTick);
+	// Emite as notas renderizadas com posição <= `position`
+	void flushDueNotes(uint32_t position);
+	// Atualiza os passos visuais (UI) para o tick atual
+	void updateVisualSteps(uint32_t tick);
 	
 	// Helper: enviar mensagem completa para saídas baseado em OutputProtocol
 	void sendMidiMessage(uint8_t status, uint8_t data1, uint8_t data2, 
@@ -75,8 +207,15 @@ private:
 public:
 	EuclideanMidiEngine() = default;
 
-	// Permite que sequenciadores enfileirem Note On/Off diretamente de forma segura
-	void enqueueNoteEvent(uint8_t channel, uint8_t note, uint8_t velocity, uint16_t noteLength, bool isNoteOn);
+	// Enfileira uma nota de forma segura (qualquer task) e, num Note On com
+	// gateUs > 0, agenda o seu Note Off. Sai apenas pelas portas de evt.ports.
+	void emitNote(const NoteEvent& evt);
+	
+	// Duração do gate em µs para uma nota que começa agora: `lengthMs` em GATE_MS;
+	// em GATE_TICKS/GATE_PERCENT calculada a partir do período de tick atual e
+	// limitada ao step (`stepTicks`) menos GATE_GUARD_US. Com ratchet
+	// (`divisions` > 1) o step é a fração de cada nota, também em GATE_MS. Task do clock.
+	uint32_t gateLengthUs(uint8_t gateMode, uint8_t gateAmount, uint16_t lengthMs, uint16_t stepTicks, uint8_t divisions = 1);
 	
 	// Inicializa engine com refs para sequenciador, clock e interfaces MIDI
 	void begin(EuclideanSequencer* seq, MidiClock* clk,
@@ -85,33 +224,51 @@ public:
 	// Define referência para OSCController (opcional)
 	void setOSCController(OSCController* oscCtrl) { osc = oscCtrl; }
 	
-	// Chamada a cada loop: processa note-off e atualiza display
-	void update();
-	
 	// Processa fila MIDI (USB)
 	// Pode ser chamada múltiplas vezes por loop para evitar overflow
 	void processMidiQueue();
 	
-	// Registra callbacks com o clock e sequenciador
-	void registerClockCallbacks();
-	
 	// Métodos públicos para callbacks (não devem ser chamados diretamente, apenas via wrappers)
 	void sendClockTick();
 	void sendClockStart();
 	void sendClockStop();
-	void onStepStart(uint8_t step);
+	// Tick de clock (task do clock): emite as notas vencidas e renderiza à frente
+	void onClockTick();
+	// Start: recomeça o render no tick 0 e emite o primeiro step com o 0xFA
+	void onTransportStart();
+	// Song Position Pointer: recomeça o render em `tick`
+	void relocate(uint32_t tick);
+	// Evento agendado pelo clock entre ticks (task do clock): emite os ratchets vencidos
+	void onScheduledEvent(uint32_t position) { flushDueNotes(position); }
+	
+	// Stop: silencia as notas que ficaram a soar
+	void onTransportStop() { allNotesOff(); }
 	
 	// Controle de Play/Stop (encapsula envio de 0xFA/0xFC para todas as saídas)
 	void sendPlayState(bool start);
 	
+	// Note Off de todas as notas ativas nas portas de `ports`; qualquer task
+	// (o worker executa-o depois dos eventos já em fila)
+	void allNotesOff(uint8_t ports = EuclideanSequencer::PORT_ALL);
+	void setRetriggerMode(RetriggerMode mode) { retriggerMode = mode; }
+	RetriggerMode getRetriggerMode() const { return retriggerMode; }
+	
 	// Getters para debug MIDI
-	uint32_t getMidiDroppedEvents() const { return midiDroppedEvents; }
-	void resetDroppedEventCounter() { midiDroppedEvents = 0; }
-	uint16_t getMidiQueueSize() const {
-		return (midiQueueHead >= midiQueueTail) ? 
-			(midiQueueHead - midiQueueTail) : 
-			(MIDI_QUEUE_SIZE - midiQueueTail + midiQueueHead);
+	uint32_t getMidiDroppedEvents() const { return midiDroppedEvents.load(); }
+	void resetDroppedEventCounter() { midiDroppedEvents.store(0); }
+	uint16_t getPendingNoteOffs() const { return noteOffWheel.size(); }
+	uint32_t getDroppedNoteOffs() const { return noteOffWheel.getDroppedEvents(); }
+	uint16_t getMidiQueueSize() const { return midiQueue.size(); }
+	uint32_t getTrackNoteCount(NoteSource source, uint8_t track) const {
+		return (source < NUM_SOURCES && track < STATS_TRACKS) ? trackNoteCount[source][track] : 0;
+	}
+	uint32_t getTrackMaxLatencyUs(NoteSource source, uint8_t track) const {
+		return (source < NUM_SOURCES && track < STATS_TRACKS) ? trackMaxLatencyUs[source][track] : 0;
 	}
+	void resetTrackStats();
+	uint16_t getActiveVoices() const { return activeVoices; }
+	uint32_t getVoiceRetriggers() const { return voiceRetriggers; }
+	uint32_t getSuppressedNoteOffs() const { return voiceSuppressedOffs; }
 	bool isOSCClientConnected() const;  // Implementação em CPP que verifica OSCController
 };
 
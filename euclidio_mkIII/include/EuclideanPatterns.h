@@ -0,0 +1,69 @@
+#ifndef EUCLIDEAN_PATTERNS_H
+#define EUCLIDEAN_PATTERNS_H
+
+#include <stdint.h>
+
+// Gerador partilhado de padrões euclidianos (sequenciador e harmónico).
+// Todos os padrões (steps, hits) até 64 steps, sem rotação, de cada algoritmo
+// são gerados em tempo de compilação (constexpr) e guardados em flash
+// (.rodata). Bit i = hit no step i. O offset é aplicado com uma rotação de
+// bits: gerar um padrão é uma leitura da tabela e um rotate, sem alocações.
+// Os limites de steps/hits/offset vivem aqui para que sequenciadores, CC MIDI,
+// OSC e presets aceitem os mesmos valores.
+class EuclideanPatterns {
+public:
+  // Algoritmo de distribuição dos hits (todos com o mesmo número de hits)
+  enum Algorithm : uint8_t {
+    ALGO_ANCHORED = 0,   // hit em i quando (i*hits)%steps < hits: primeiro hit no step 0 (por omissão)
+    ALGO_BJORKLUND = 1,  // Bjorklund clássico (agrupamento de restos), começa num hit
+    ALGO_BRESENHAM = 2,  // linha de Bresenham: hit no fim de cada grupo, último step com hit
+    ALGO_COUNT
+  };
+
+  static const uint8_t MIN_STEPS = 1;
+  static const uint8_t MAX_STEPS = 64;
+  static const uint8_t MIN_HITS = 1;
+  static const uint8_t MAX_HITS = MAX_STEPS;
+  // Entradas por número de steps s = 1..64: hits 0..s
+  static const uint16_t TABLE_SIZE = (uint16_t)((MAX_STEPS - 1) * (MAX_STEPS + 2) / 2 + MAX_STEPS + 1);
+
+  // Padrão sem rotação (steps limitado a 64, hits a steps; 0 se steps ou hits forem 0)
+  static uint64_t base(uint8_t steps, uint8_t hits, Algorithm algo = ALGO_ANCHORED);
+
+  // Roda um padrão de `steps` passos `offset` passos para a direita
+  static uint64_t rotate(uint64_t mask, uint8_t steps, uint8_t offset) {
+    if (steps == 0 || steps > MAX_STEPS) return mask;
+    uint8_t off = offset % steps;
+    if (off == 0) return mask;
+    return ((mask << off) | (mask >> (steps - off))) & lowMask(steps);
+  }
+
+  // Padrão com offset aplicado
+  static uint64_t get(uint8_t steps, uint8_t hits, uint8_t offset, Algorithm algo = ALGO_ANCHORED) {
+    if (steps > MAX_STEPS) steps = MAX_STEPS;
+    return rotate(base(steps, hits, algo), steps, offset);
+  }
+
+  // Limites comuns (valores de entrada como int para não truncar antes de limitar)
+  static uint8_t clampSteps(int steps) {
+    return (uint8_t)(steps < MIN_STEPS ? MIN_STEPS : (steps > MAX_STEPS ? MAX_STEPS : steps));
+  }
+  static uint8_t clampHits(int hits) {
+    return (uint8_t)(hits < MIN_HITS ? MIN_HITS : (hits > MAX_HITS ? MAX_HITS : hits));
+  }
+  static Algorithm clampAlgorithm(int algo) {
+    return (algo >= 0 && algo < ALGO_COUNT) ? (Algorithm)algo : ALGO_ANCHORED;
+  }
+
+  // Máscara com os `steps` bits mais baixos ligados
+  static constexpr uint64_t lowMask(uint8_t steps) {
+    return (steps >= 64) ? ~0ULL : ((1ULL << steps) - 1);
+  }
+
+  // Primeira entrada do bloco de `steps` (1..64) na tabela
+  static constexpr uint16_t rowStart(uint8_t steps) {
+    return (uint16_t)((steps - 1) * (steps + 2) / 2);
+  }
+};
+
+#endif // EUCLIDEAN_PATTERNS_H
@@ -2,13 +2,34 @@
 #define EUCLIDEAN_SEQUENCER_H
 
 #include <Arduino.h>
-#include <vector>
+#include "EuclideanPatterns.h"
+
+// Número de tracks do sequenciador rítmico, fixo em compilação (8..64):
+// -DEUCLID_TRACKS=64 nos build_flags do platformio.ini
+#ifndef EUCLID_TRACKS
+#define EUCLID_TRACKS 32
+#endif
 
 class EuclideanSequencer {
+public:
+  static const uint8_t MAX_TRACKS = EUCLID_TRACKS;
+  static_assert(EUCLID_TRACKS >= 8 && EUCLID_TRACKS <= 64, "EUCLID_TRACKS: 8..64");
+
+  // Conjunto de tracks, um bit por track. Até 32 tracks cabe numa palavra de
+  // 32 bits (leitura atómica entre tasks no ESP32).
+#if EUCLID_TRACKS > 32
+  typedef uint64_t TrackMask;
+  static uint8_t lowestTrack(TrackMask m) { return (uint8_t)__builtin_ctzll(m); }
+#else
+  typedef uint32_t TrackMask;
+  static uint8_t lowestTrack(TrackMask m) { return (uint8_t)__builtin_ctz(m); }
+#endif
+  static TrackMask trackBit(uint8_t trackIdx) { return (TrackMask)1 << trackIdx; }
+
 private:
-  static const uint8_t MAX_STEPS = 16;      // máximo de passos na sequência
-  static const uint8_t MAX_HITS = 16;       // máximo de hits (notas) na sequência (1..16)
-  static const uint8_t MAX_PATTERNS = 8;    // máximo de padrões salvos
+  static const uint8_t MAX_STEPS = EuclideanPatterns::MAX_STEPS;  // máximo de passos na sequência (1..64)
+  static const uint8_t MAX_HITS = EuclideanPatterns::MAX_HITS;    // máximo de hits (notas) na sequência (1..64)
+  static const uint8_t MAX_PATTERNS = MAX_TRACKS;  // máximo de padrões salvos (um por track)
   static const uint8_t DEFAULT_STEPS = 8;  // 8 passos padrão
   static const uint8_t MIDI_PPQN = 24;      // 24 pulsos por quarter note
 
@@ -21,7 +42,7 @@ public:
 
 private:
   struct EuclideanPattern {
-    uint8_t steps;                          // número total de passos (1-32)
+    uint8_t steps;                          // número total de passos (1-64)
     uint8_t hits;                           // número de hits a distribuir (0-steps)
     uint8_t offset;                         // rotação do padrão (0-steps)
     uint8_t note;                           // nota MIDI (0-127)
@@ -32,22 +53,49 @@ private:
     PlayMode playMode;                      // modo de sincronização da trilha
     bool active;                            // (antigo, pode ser mantido para compatibilidade)
     bool enabled;                           // NOVO: permite ligar/desligar a track individualmente
+    uint8_t outputPorts;                    // portas de saída da track (OutputPort, bitmask)
+    uint8_t gateMode;                       // GateMode: noteLength em ms, ticks ou % do step
+    uint8_t gateAmount;                     // ticks de 24 PPQN (1-96) ou percentagem (1-100)
+    uint8_t algorithm;                      // EuclideanPatterns::Algorithm
+    uint8_t probability;                    // probabilidade de um hit tocar (0-100 %, 100 = sempre)
+    uint8_t ratchet;                        // notas por hit, repartidas pelo step (1 = sem ratchet, 2-8)
+    uint64_t chanceSteps;                   // steps sujeitos à probabilidade (bit i = step i)
+    uint64_t ratchetSteps;                  // steps com ratchet (bit i = step i)
   };
 public:
   // Novo: enable/disable por track
   bool isTrackEnabled(uint8_t trackIdx) const;
   void setTrackEnabled(uint8_t trackIdx, bool enabled);
+  // Portas de saída por track (OutputPort); por omissão todas
+  uint8_t getTrackOutputPorts(uint8_t trackIdx) const;
+  void setTrackOutputPorts(uint8_t trackIdx, uint8_t ports);
 
-  std::vector<bool> pattern;                // padrão euclidiano atual (true = hit, false = rest)
+  uint64_t pattern;                         // padrão euclidiano atual, rodado (bit i = hit no step i)
   EuclideanPattern currentConfig;
   EuclideanPattern patterns[MAX_PATTERNS];  // padrões salvos
   
   uint8_t currentStep;                      // posição atual na sequência
   uint8_t selectedPattern;                  // índice do padrão selecionado
-  uint8_t trackCurrentStep[8];              // passo atual de cada track para UI
+  uint8_t trackCurrentStep[MAX_TRACKS];              // passo atual de cada track para UI
+  volatile uint8_t trackEditGen[MAX_TRACKS];         // incrementa a cada edição da track (render antecipado)
+  
+  // Estado lido a cada tick, por track (struct-of-arrays): padrão pré-calculado
+  // (bit i = hit no step i, já rodado pelo offset, 0 com a track inativa),
+  // steps e resolução. Refeito em cada edição, para que o tick só leia arrays
+  // contíguos das tracks que tocam e avalie um step com um shift e uma máscara.
+  // A configuração completa (patterns) só é lida nas fronteiras de step.
+  uint64_t trackMask[MAX_TRACKS];
+  uint8_t trackStepCount[MAX_TRACKS];
+  uint8_t trackResolution[MAX_TRACKS];
+  TrackMask playingTracks;                           // bit por track ativa e ligada
+  
+  // Marca a configuração da track como alterada (refaz a máscara e a geração)
+  void touchTrack(uint8_t trackIdx);
+  void rebuildTrackMask(uint8_t trackIdx);
   
   bool isRunning;
   unsigned long lastStepTime;
+  uint32_t randomSeed = DEFAULT_RANDOM_SEED;
   
 
 public:
@@ -80,14 +128,43 @@ public:
     OUT_ALL = 0x0F
   };
   
+  // Portas de saída de notas por track: um bit por índice de saída do MIDIRouter
+  // (0=DIN1, 1=DIN2, 2=DIN3, 4=USB). O OutputProtocol global continua a
+  // ligar/desligar cada protocolo; a máscara escolhe as portas de cada track.
+  enum OutputPort : uint8_t {
+    PORT_DIN1 = 0x01,
+    PORT_DIN2 = 0x02,
+    PORT_DIN3 = 0x04,
+    PORT_USB = 0x10,
+    PORT_ALL = 0x17
+  };
+  
+  // Duração do gate: em ms fixos (noteLength) ou no domínio do clock, em ticks
+  // de 24 PPQN ou em percentagem do step. Nos dois últimos o Note Off é
+  // calculado no Note On a partir do período de tick atual.
+  enum GateMode : uint8_t {
+    GATE_MS = 0,
+    GATE_TICKS = 1,
+    GATE_PERCENT = 2,
+    GATE_MODE_COUNT
+  };
+  static const uint8_t MAX_GATE_TICKS = 96;
+  static const uint8_t DEFAULT_GATE_AMOUNT = 50;
+  
+  // Probabilidade e ratchet por track; as máscaras escolhem os steps a que se
+  // aplicam (por omissão todos). A decisão é tirada de um xorshift por track,
+  // semeado a partir de randomSeed e da track em cada Start/SPP: com a mesma
+  // semente e as mesmas edições, a performance repete-se.
+  static const uint8_t MAX_PROBABILITY = 100;
+  static const uint8_t MAX_RATCHET = 8;
+  static const uint64_t ALL_STEPS = ~0ULL;
+  static const uint32_t DEFAULT_RANDOM_SEED = 0x2545F491;
+  
 public:
 
-  // Função interna para gerar padrão euclidiano
+  // Função interna para gerar padrão euclidiano (tabela em flash + rotação)
   void generatePattern();
   
-  // Algoritmo de Bjorklund para sequências euclidianas
-  void bjorklundAlgorithm(uint8_t steps, uint8_t hits);
-  
   EditParam currentEditParam;
   // Saídas separadas (antigo, mantido por compatibilidade)
   OutputProtocol outputNotes = OUT_DIN;
@@ -116,6 +193,19 @@ public:
   void setMidiChannel(uint8_t channel);
   void setResolution(uint8_t res);  // 1=1/4, 2=1/8, 3=1/16, 4=1/32
   void setNoteLength(uint16_t length);  // duração nota em ms (50-500)
+  void setGateMode(GateMode mode);
+  void setGateAmount(uint8_t amount);   // ticks (1-96) ou % (1-100) conforme o modo
+  void setAlgorithm(EuclideanPatterns::Algorithm algo);
+  void setProbability(uint8_t percent);  // 0-100 %
+  void setRatchet(uint8_t count);        // 1-8 notas por hit
+  // Por step (índice do step tocado, já com o offset): sujeito à probabilidade / com ratchet
+  void setStepChance(uint8_t step, bool on);
+  void setStepRatchet(uint8_t step, bool on);
+  void setChanceSteps(uint64_t mask);
+  void setRatchetSteps(uint64_t mask);
+  // Semente das decisões aleatórias (aplicada no próximo Start/SPP)
+  void setRandomSeed(uint32_t seed) { randomSeed = seed; }
+  uint32_t getRandomSeed() const { return randomSeed; }
   // Saídas
   void setOutputNotes(OutputProtocol out) { outputNotes = out; }
   void setOutputClock(OutputProtocol out) { outputClock = out; }
@@ -142,17 +232,33 @@ public:
   
   // Polyphony: obter dados de múltiplas tracks
   bool isTrackActive(uint8_t trackIdx) const;
-  bool getTrackPatternBit(uint8_t trackIdx, uint8_t step) const;
+  bool getTrackPatternBit(uint8_t trackIdx, uint8_t step) const {
+    return trackIdx < MAX_PATTERNS && step < trackStepCount[trackIdx] && ((trackMask[trackIdx] >> step) & 1);
+  }
+  // Padrão completo da track (bit i = hit no step i; 0 se inativa)
+  uint64_t getTrackPatternMask(uint8_t trackIdx) const { return (trackIdx < MAX_PATTERNS) ? trackMask[trackIdx] : 0; }
+  // Tracks ativas e ligadas (bit por track): iterar só os bits ligados
+  TrackMask getPlayingTracks() const { return playingTracks; }
   // Passo atual por track (para UI multi-agulhas)
-  void setTrackCurrentStep(uint8_t trackIdx, uint8_t step) { if (trackIdx < 8) trackCurrentStep[trackIdx] = step; }
-  uint8_t getTrackCurrentStep(uint8_t trackIdx) const { return (trackIdx < 8) ? trackCurrentStep[trackIdx] : 0; }
+  void setTrackCurrentStep(uint8_t trackIdx, uint8_t step) { if (trackIdx < MAX_TRACKS) trackCurrentStep[trackIdx] = step; }
+  uint8_t getTrackCurrentStep(uint8_t trackIdx) const { return (trackIdx < MAX_TRACKS) ? trackCurrentStep[trackIdx] : 0; }
+  // Geração de edição: muda sempre que algum parâmetro da track é alterado
+  uint8_t getTrackEditGen(uint8_t trackIdx) const { return (trackIdx < MAX_TRACKS) ? trackEditGen[trackIdx] : 0; }
   // Getters para track config
   uint8_t getTrackNote(uint8_t trackIdx) const;
   uint8_t getTrackVelocity(uint8_t trackIdx) const;
   uint8_t getTrackMidiChannel(uint8_t trackIdx) const;
-  uint8_t getTrackResolution(uint8_t trackIdx) const;
-  uint8_t getTrackSteps(uint8_t trackIdx) const;
+  // Resolução e steps: arrays por track (1 e DEFAULT_STEPS com a track inativa)
+  uint8_t getTrackResolution(uint8_t trackIdx) const { return (trackIdx < MAX_TRACKS) ? trackResolution[trackIdx] : 1; }
+  uint8_t getTrackSteps(uint8_t trackIdx) const { return (trackIdx < MAX_TRACKS) ? trackStepCount[trackIdx] : DEFAULT_STEPS; }
   uint16_t getTrackNoteLength(uint8_t trackIdx) const;
+  GateMode getTrackGateMode(uint8_t trackIdx) const;
+  uint8_t getTrackGateAmount(uint8_t trackIdx) const;
+  EuclideanPatterns::Algorithm getTrackAlgorithm(uint8_t trackIdx) const;
+  uint8_t getTrackProbability(uint8_t trackIdx) const;
+  uint8_t getTrackRatchet(uint8_t trackIdx) const;
+  uint64_t getTrackChanceSteps(uint8_t trackIdx) const;
+  uint64_t getTrackRatchetSteps(uint8_t trackIdx) const;
   // Novos getters para preservação de presets
   uint8_t getTrackHits(uint8_t trackIdx) const;
   uint8_t getTrackOffset(uint8_t trackIdx) const;
@@ -180,6 +286,13 @@ public:
   uint8_t getMidiChannel() const { return currentConfig.midiChannel; }
   uint8_t getResolution() const { return currentConfig.resolution; }
   uint16_t getNoteLength() const { return currentConfig.noteLength; }
+  GateMode getGateMode() const { return (GateMode)currentConfig.gateMode; }
+  uint8_t getGateAmount() const { return currentConfig.gateAmount; }
+  EuclideanPatterns::Algorithm getAlgorithm() const { return (EuclideanPatterns::Algorithm)currentConfig.algorithm; }
+  uint8_t getProbability() const { return currentConfig.probability; }
+  uint8_t getRatchet() const { return currentConfig.ratchet; }
+  uint64_t getChanceSteps() const { return currentConfig.chanceSteps; }
+  uint64_t getRatchetSteps() const { return currentConfig.ratchetSteps; }
   OutputProtocol getOutputNotes() const { return outputNotes; }
   OutputProtocol getOutputClock() const { return outputClock; }
   bool getOutputMidiMap() const { return outputMidiMap; }
@@ -2,6 +2,8 @@
 #define MIDI_ROUTER_H
 
 #include <stdint.h>
+#include "MidiTxScheduler.h"
+#include "UsbMidiPacketizer.h"
 
 class RoutingMatrix;
 class EuclideanSequencer;
@@ -15,11 +17,35 @@ public:
 	
 	// Inicializa os pinos de saída serial MIDI e referencia USB
 	static void begin();
-	static void setUsbInterface(Adafruit_USBD_MIDI* usb) { usb_midi = usb; }
+	static void setUsbInterface(Adafruit_USBD_MIDI* usb) { usb_midi = usb; usbTx.begin(usb); }
 	
-	// Envia um byte para uma saída MIDI específica
+	// Envia um byte de tempo real para uma saída MIDI específica
 	static void sendToOutput(uint8_t outIndex, uint8_t b);
 	
+	// Envia uma mensagem completa para uma saída. Nas DIN passa pelo agendador
+	// de transmissão com a prioridade da mensagem, ou `prio` se indicada
+	// (p.ex. feedback como CC, para nunca atrasar notas; thru como PRIO_THRU,
+	// para não reordenar o que chega da entrada)
+	static const uint8_t AUTO_PRIORITY = 0xFF;
+	static void sendMessageToOutput(uint8_t outIndex, uint8_t status, uint8_t data1, uint8_t data2,
+	                                uint8_t prio = AUTO_PRIORITY);
+	
+	// Entrega às DIN o que o orçamento de cada porta permite (worker MIDI)
+	static void pumpDinOutputs() { dinTx.pump(); }
+	static bool hasPendingDinOutput() { return dinTx.hasPending(); }
+	// Estatísticas por porta DIN (bytes, profundidade de fila, overflow, feedback reduzido)
+	static const MidiTxScheduler& getDinScheduler() { return dinTx; }
+	static void resetDinStats() { dinTx.resetStats(); }
+	// Running status nas DIN e Note Off enviado como Note On com velocity 0
+	static void setDinRunningStatus(bool enabled) { dinTx.setRunningStatus(enabled); }
+	static void setDinNoteOffAsNoteOn(bool enabled) { dinTx.setNoteOffAsNoteOn(enabled); }
+	
+	// A saída USB acumula pacotes USB-MIDI; cada produtor esvazia-os no fim do seu ciclo
+	static void flushUsbOutput() { usbTx.flush(); }
+	// Estatísticas USB (pacotes por flush, latência de flush, pacotes perdidos)
+	static const UsbMidiPacketizer& getUsbPacketizer() { return usbTx; }
+	static void resetUsbStats() { usbTx.resetStats(); }
+	
 	// Roteia um byte simples de uma entrada para saídas habilitadas
 	static void routeByteFromInput(uint8_t inIndex, uint8_t b);
 	
@@ -29,11 +55,19 @@ public:
 	// Roteia mensagens em tempo real (Clock, Start, Stop, etc)
 	static void routeRealTimeMessage(uint8_t inIndex, uint8_t message);
 
-	// Callbacks para enviar Start/Stop/Clock a saídas selecionadas
-	static void sendRealtimeToClockOutputs(uint8_t message);
+	// Song Position Pointer (0xF2 + LSB + MSB) recebido numa entrada
+	static void routeSongPosition(uint8_t inIndex, uint8_t lsb, uint8_t msb);
+
+	// Callbacks para enviar Start/Stop/Clock (e SPP, com dados) a saídas selecionadas
+	static void sendRealtimeToClockOutputs(uint8_t message, uint8_t data1 = 0, uint8_t data2 = 0);
 	static void clockTickCallback();
+	static void clockPulseCallback(uint32_t position);
 	static void startCallback();
 	static void stopCallback();
+	static void continueCallback();
+	static void locateCallback(uint32_t tick);
+	// Evento agendado entre ticks (ratchets do sequenciador euclidiano)
+	static void scheduledEventCallback(uint32_t position);
 	
 	// Define a matriz de roteamento a usar
 	static void setRoutingMatrix(RoutingMatrix* matrix) { routingMatrix = matrix; }
@@ -49,6 +83,8 @@ private:
 	static EuclideanSequencer* euclideanSeq;
 	static MidiClock* midiClock;
 	static Adafruit_USBD_MIDI* usb_midi;
+	static MidiTxScheduler dinTx;
+	static UsbMidiPacketizer usbTx;
 };
 
 #endif // MIDI_ROUTER_H
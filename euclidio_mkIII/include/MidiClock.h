@@ -2,6 +2,8 @@
 #define MIDI_CLOCK_H
 
 #include <Arduino.h>
+#include <atomic>
+#include "TempoTracker.h"
 
 class MidiClock {
 public:
@@ -18,6 +20,71 @@ public:
     CLOCK_DIN  = 0x04
   };
 
+  // Linha temporal interna de alta resolução; o clock MIDI (24 PPQN) é derivado dela
+  static const uint16_t PPQN_INTERNAL = 960;
+  static const uint8_t SUBTICKS_PER_TICK = 40;  // PPQN_INTERNAL / 24
+  static const uint8_t MAX_SCHEDULED_EVENTS = 32;
+
+  // Evento de tempo real com o instante exato em que ocorreu
+  enum RealTimeType : uint8_t {
+    RT_TICK = 0,
+    RT_START,
+    RT_STOP,
+    RT_CONTINUE,
+    RT_LOCATE,           // Song Position Pointer: position = novo ponto da linha temporal
+    RT_GRID              // ponto da grelha de saída entre ticks (clock multiplicado)
+  };
+  struct RealTimeEvent {
+    uint8_t type;        // RealTimeType
+    uint32_t timeUs;     // micros() no momento do evento
+    uint32_t position;   // posição 960 PPQN no momento do evento
+  };
+  static const uint8_t RT_RING_SIZE = 64;  // potência de 2
+
+  // Fontes de clock externas (inIndex 0..2 = DIN1..DIN3, 3 = BLE, 4 = USB)
+  static const uint8_t NUM_CLOCK_SOURCES = 5;
+  static const uint8_t NO_CLOCK_SOURCE = 0xFF;
+  struct ClockSourceStats {
+    uint32_t lastClockUs;      // instante do último clock recebido
+    uint32_t lastInterval;     // último intervalo entre clocks (µs)
+    uint32_t minInterval;      // intervalo mínimo observado (µs)
+    uint32_t maxInterval;      // intervalo máximo observado (µs)
+    uint32_t avgInterval;      // média móvel do intervalo (µs)
+    uint32_t avgJitter;        // média móvel do desvio face à média (µs)
+    uint32_t clockCount;       // clocks recebidos
+    uint8_t consistentCount;   // intervalos consecutivos dentro da tolerância
+  };
+
+  // Taxa do clock por saída (inIndex/outIndex 0..2 = DIN1..DIN3, 4 = USB),
+  // derivada da linha temporal 960 PPQN sem timers adicionais
+  static const uint8_t NUM_CLOCK_OUTPUTS = 5;
+  enum ClockRate : uint8_t {
+    RATE_X2 = 0,   // 48 PPQN
+    RATE_X1,       // 24 PPQN (normal)
+    RATE_DIV2,     // 12 PPQN
+    RATE_DIV4      // 6 PPQN
+  };
+
+  // Clock de saída em SLAVE
+  enum ClockOutMode : uint8_t {
+    CLOCK_OUT_REGEN = 0,  // regenerado pelo timer a partir do tempo/fase estimados (sem jitter da entrada)
+    CLOCK_OUT_ECHO        // cada 0xF8 recebido é reenviado quando chega
+  };
+
+  // O que fazer com ticks que chegam atrasados à task (task sem CPU, ex. WiFi)
+  enum CatchUpPolicy : uint8_t {
+    CATCHUP_BURST = 0,   // processa todos de seguida (comportamento original)
+    CATCHUP_SPREAD,      // distribui os atrasados pelo intervalo seguinte
+    CATCHUP_DROP         // não renderiza os atrasados (os 0xF8 saem na mesma) e ressincroniza no mais recente
+  };
+  static const uint16_t LATE_TICK_US = 1000;  // atraso a partir do qual um tick conta como tardio
+
+  // Forma da rampa de tempo
+  enum TempoRampShape : uint8_t {
+    RAMP_LINEAR = 0,      // BPM varia linearmente
+    RAMP_EXPONENTIAL      // BPM varia por um fator constante por tick
+  };
+
 private:
   static const uint8_t MIDI_CLOCK = 0xF8;
   static const uint8_t MIDI_START = 0xFA;
@@ -25,6 +92,7 @@ private:
   static const uint8_t MIDI_CONTINUE = 0xFB;
   
   static const uint8_t PPQN_BASE = 24;      // 24 pulsos por quarter note (não muda)
+  static const uint8_t TICKS_PER_SONG_POS = 6;  // SPP conta semicolcheias (6 ticks)
   
   hw_timer_t* timerHandle;
   float bpm;
@@ -34,20 +102,137 @@ private:
   uint8_t ticksPerStep;                     // quantos ticks disparam um step (configurável)
   bool isRunning;
   SyncMode syncMode;                        // MASTER ou SLAVE
-  unsigned long lastExternalClockTime;      // timestamp do último clock externo recebido
-  
-  // Debug: jitter do clock externo
-  unsigned long lastClockInterval;          // intervalo em ms entre clocks
-  uint16_t minClockInterval;                // intervalo mínimo observado
-  uint16_t maxClockInterval;                // intervalo máximo observado
-  uint32_t clockCount;                      // contador de clocks recebidos (para debug)
+
+  // Arbitragem: cada entrada é seguida em separado; só a fonte primária
+  // alimenta o TempoTracker (duas fontes ativas não duplicam o tempo)
+  static const uint8_t SOURCE_STABLE_CLOCKS = 8;     // intervalos consistentes para ser candidata
+  static const uint8_t SOURCE_TIMEOUT_PERIODS = 4;   // períodos sem clock até a fonte ser dada como perdida
+  static const uint32_t SOURCE_TIMEOUT_US = 250000;  // idem, enquanto não há período estimado
+  ClockSourceStats sources[NUM_CLOCK_SOURCES];
+  uint8_t primarySource = NO_CLOCK_SOURCE;
+  uint32_t clockFailovers = 0;
+
+  ClockOutMode clockOutMode = CLOCK_OUT_REGEN;
+
+  // Divisão/multiplicação e fase por saída; a grelha do timer desce para
+  // meio tick apenas quando alguma saída está em x2
+  uint8_t outputClockRate[NUM_CLOCK_OUTPUTS] = {RATE_X1, RATE_X1, RATE_X1, RATE_X1, RATE_X1};
+  int8_t outputClockOffset[NUM_CLOCK_OUTPUTS] = {0, 0, 0, 0, 0};  // em ticks
+  volatile uint32_t gridSubticks = SUBTICKS_PER_TICK;
+  static uint16_t rateIntervalSubticks(uint8_t rate);
+  void updateOutputGrid();
+  ClockSourceStats outputStats;             // intervalos dos ticks enviados (saídas de clock)
+
+  static void updateClockStats(ClockSourceStats& stats, uint32_t nowUs);
+  bool isSourceAlive(uint8_t inIndex, uint32_t nowUs) const;
+  bool isSourceStable(uint8_t inIndex) const { return sources[inIndex].consistentCount >= SOURCE_STABLE_CLOCKS; }
+  // Devolve true se o clock de `inIndex` deve conduzir o tempo (pode mudar a primária)
+  bool arbitrateClock(uint8_t inIndex, uint32_t nowUs);
+
+  // SLAVE: o timer interno gera os ticks a partir da estimativa do TempoTracker
+  static const uint8_t SLAVE_FREEWHEEL_TICKS = 3;  // ticks gerados sem clock externo antes de parar
+  static const uint8_t SLAVE_RESYNC_TICKS = 2;     // atraso (em ticks) que força ressincronização
+  TempoTracker tempoTracker;
+  portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
+  volatile uint32_t slaveExtTicks = 0;      // ticks contados na fonte externa desde o Start
+  volatile uint32_t slaveGenTicks = 0;      // ticks gerados internamente desde o Start
+  volatile uint32_t lastGenTickUs = 0;      // instante do último tick gerado
+  volatile bool slaveTimerActive = false;   // timer a gerar ticks em SLAVE (PLL em lock)
+
+  void resetSlaveTracking();
+
+  // Período de um subtick (960 PPQN) em µs como fração q + r/den. Um acumulador
+  // tipo Bresenham distribui o resto evento a evento, pelo que a taxa média é
+  // exata a qualquer BPM (inclusive não inteiro) e não há deriva face a um DAW.
+  struct SubtickPeriod {
+    uint32_t q;
+    uint32_t r;
+    uint32_t den;
+  };
+  static const uint32_t US_PER_SUBTICK_MILLIBPM = 62500000UL;  // 60e6 / 960 * 1000
+  SubtickPeriod subtickPeriod = {520, 100000, 120000};          // 120 BPM
+  SubtickPeriod pendingSubtickPeriod = {520, 100000, 120000};
+  volatile bool subtickPeriodPending = false;
+  uint32_t subtickPeriodAcc = 0;
+
+  static SubtickPeriod periodFromBPM(float bpm);
+  static SubtickPeriod periodFromTickUs(float tickPeriodUs);
+  // Agenda novo período; o ISR adota-o no próximo evento da linha temporal
+  void setSubtickPeriod(const SubtickPeriod& period);
+  // Duração em µs de `subticks` subticks (chamado no ISR, com timerMux)
+  uint32_t spanDurationUs(uint32_t subticks);
+
+  // Posição na linha temporal (960 PPQN desde o Start), avançada pelo ISR.
+  // O timer é armado para o próximo evento: fronteira de tick ou evento agendado.
+  volatile uint32_t position = 0;
+  uint32_t armedSpan = SUBTICKS_PER_TICK;   // subticks até ao evento armado
+  uint32_t scheduled[MAX_SCHEDULED_EVENTS]; // posições agendadas (ordenadas)
+  uint8_t scheduledCount = 0;
+  volatile uint32_t nextScheduledPos = 0xFFFFFFFF;
+
+  // Calcula o próximo evento e devolve a sua distância em µs (ISR, com timerMux)
+  uint32_t armNextEvent();
+  // Reinicia o contador do timer e arma o primeiro evento
+  void armTimer();
+  // Dispara callbacks dos eventos agendados já atingidos (contexto de task)
+  void processScheduledEvents();
   
+  // Ring lock-free de eventos de tempo real (ISR/receiveExternalClock -> task).
+  // Os produtores escrevem sempre com timerMux tomado (já necessário para a
+  // linha temporal), logo há um único produtor efetivo; o consumidor (task do
+  // clock) lê sem mascarar interrupções.
+  RealTimeEvent rtRing[RT_RING_SIZE];
+  std::atomic<uint8_t> rtHead{0};           // escrito pelo produtor
+  std::atomic<uint8_t> rtTail{0};           // escrito pelo consumidor
+  volatile uint32_t rtDroppedEvents = 0;    // eventos perdidos por ring cheio
+  RealTimeEvent currentEvent = {RT_TICK, 0, 0};  // evento em processamento (contexto de task)
+
+  // Recuperação de ticks atrasados e estatísticas de latência da task
+  CatchUpPolicy catchUpPolicy = CATCHUP_BURST;
+  uint32_t lastTickEventUs = 0;             // instante do último tick processado
+  uint32_t tickIntervalUs = 0;              // intervalo entre os dois últimos ticks
+  uint32_t nextSpreadUs = 0;                // SPREAD: instante do próximo tick atrasado
+  bool spreading = false;                   // SPREAD: episódio de atraso em curso (nextSpreadUs válido)
+  volatile uint32_t lateTicks = 0;          // ticks processados com atraso > LATE_TICK_US
+  volatile uint32_t droppedLateTicks = 0;   // ticks atrasados descartados (DROP)
+  volatile uint32_t tickBursts = 0;         // acordares que enviaram mais de um tick
+  volatile uint16_t maxTickBurst = 0;       // maior rajada de ticks num só acordar
+  volatile uint32_t maxTaskLatenessUs = 0;  // pior atraso evento -> processamento
+
+  // Rampa de tempo (MASTER): novo período calculado a cada tick na task e
+  // adotado pelo ISR na fronteira seguinte, nunca a meio de um tick
+  volatile bool rampActive = false;
+  TempoRampShape rampShape = RAMP_LINEAR;
+  float rampStartBpm = 120.0f;
+  float rampEndBpm = 120.0f;
+  uint32_t rampStartTick = 0;               // tickCount em que a rampa começa
+  uint32_t rampTicks = 0;                   // duração em ticks (beats * 24)
+
+  // Aplica um BPM sem cancelar a rampa em curso
+  void applyBPM(float newBpm);
+  // Avança a rampa de tempo (contexto de task, a cada tick)
+  void updateTempoRamp();
+
+  // Avança contadores de tick/step e envia os pulsos de clock das saídas; com
+  // `dispatch` chama também os callbacks de step e de tick (render das notas)
+  void advanceTick(bool dispatch);
+  // Número de eventos ainda no ring (contexto do consumidor)
+  uint8_t pendingRealTimeEvents() const;
+
+  // Publica um evento no ring (chamar com timerMux tomado); false se cheio
+  bool pushRealTimeEvent(uint8_t type, uint32_t timeUs, uint32_t pos);
+  // Acorda a task do clock (ou nada, se o loop() processa os eventos)
+  void notifyClockTask();
+
   // Callbacks para enviar clock MIDI
   void (*onClockTick)() = nullptr;
   void (*onStart)() = nullptr;
   void (*onStop)() = nullptr;
   void (*onContinue)() = nullptr;
+  void (*onLocate)(uint32_t tick) = nullptr;
+  void (*onClockPulse)(uint32_t position) = nullptr;
   void (*onStepStart)(uint8_t step) = nullptr;
+  void (*onScheduledEvent)(uint32_t position) = nullptr;
 
   // Seleção de onde o clock é enviado/recebido (bitmask de ClockIO)
   ClockIO clockIO = CLOCK_USB; // default: USB
@@ -57,67 +242,129 @@ public:
   MidiClock();
   
   void begin(float initialBpm = 120.0);
-  void setBPM(float bpm);
+  void setBPM(float bpm);  // salto imediato de tempo (cancela rampa em curso)
   float getBPM() const { return bpm; }
+  // Duração de um tick (24 PPQN) em µs ao período mais recente (inclui rampas e SLAVE)
+  uint32_t getTickPeriodUs();
+
+  // Rampa de tempo até `targetBpm` ao longo de `beats` beats, a começar no
+  // tick `atTick` (0 = próximo tick). Só em MASTER; o clock MIDI enviado
+  // acompanha a rampa tick a tick.
+  bool startTempoRamp(float targetBpm, uint16_t beats, TempoRampShape shape = RAMP_LINEAR, uint32_t atTick = 0);
+  void cancelTempoRamp() { rampActive = false; }
+  bool isTempoRamping() const { return rampActive; }
   void setTicksPerStep(uint8_t ticks) { ticksPerStep = ticks; }
   uint8_t getTicksPerStep() const { return ticksPerStep; }
   
   // Controle de modo de sincronização
-  void setSyncMode(SyncMode mode) { syncMode = mode; }
+  void setSyncMode(SyncMode mode);
   SyncMode getSyncMode() const { return syncMode; }
   bool isMaster() const { return syncMode == MASTER; }
   bool isSlave() const { return syncMode == SLAVE; }
   
-  // Recebe clock MIDI externo (chamado pelo MIDIRouter)
-  void receiveExternalClock();
+  // Recebe clock MIDI externo da entrada `inIndex` (chamado pelo MIDIRouter)
+  void receiveExternalClock(uint8_t inIndex);
+
+  // Estimativa de tempo/fase do clock externo (SLAVE)
+  bool isExternalLocked() const { return tempoTracker.isLocked(); }
+  float getExternalBPM() const { return tempoTracker.getBPM(); }
+  const TempoTracker& getTempoTracker() const { return tempoTracker; }
   
   void start();
   void stop();
   void reset();
+  // Continue (0xFB): retoma a partir da posição atual sem voltar a zero
+  void resume();
+  // Song Position Pointer (0xF2): reposiciona em `songPos` semicolcheias.
+  // O tickCount é atualizado na task do clock, pela ordem dos ticks, e o
+  // callback de locate recalcula os passos de cada track.
+  void locate(uint16_t songPos);
+  uint16_t getSongPosition() const { return (uint16_t)(tickCount / TICKS_PER_SONG_POS); }
   
   bool isRunningState() const { return isRunning; }
   uint32_t getTickCount() const { return tickCount; }
   uint8_t getBeatCount() const { return tickCount / 24; }  // 24 ticks por beat
   uint8_t getCurrentStep() const { return currentStep; }
   uint8_t getCurrentPPQN() const { return currentPPQN; }
+  // Posição 960 PPQN atual (40 subticks por tick de clock MIDI)
+  uint32_t getPosition() const { return position; }
+  // Instante (micros) e posição do evento em processamento: válidos dentro dos
+  // callbacks de clock/step/start/stop, dão o tempo exato do tick que os gerou
+  uint32_t getEventTime() const { return currentEvent.timeUs; }
+  uint32_t getEventPosition() const { return currentEvent.position; }
+  uint32_t getDroppedRealTimeEvents() const { return rtDroppedEvents; }
+
+  // Agenda um evento numa posição 960 PPQN futura (microtiming, swing,
+  // subdivisões ímpares). O timer dispara exatamente nessa posição e o
+  // callback de eventos agendados é chamado na task do clock.
+  // Devolve false se a posição já passou ou a agenda está cheia.
+  bool scheduleAt(uint32_t pos);
   
   // Callbacks para integração externa
   void setClockCallback(void (*callback)()) { onClockTick = callback; }
   void setStartCallback(void (*callback)()) { onStart = callback; }
   void setStopCallback(void (*callback)()) { onStop = callback; }
   void setContinueCallback(void (*callback)()) { onContinue = callback; }
+  void setLocateCallback(void (*callback)(uint32_t)) { onLocate = callback; }
+  // Chamado em cada ponto da grelha de saída (ticks e, com x2, meios ticks);
+  // usar isClockPulseDue() para decidir que saídas recebem 0xF8
+  void setClockPulseCallback(void (*callback)(uint32_t)) { onClockPulse = callback; }
   void setStepStartCallback(void (*callback)(uint8_t)) { onStepStart = callback; }
+  void setScheduledEventCallback(void (*callback)(uint32_t)) { onScheduledEvent = callback; }
 
   // Acesso à seleção de Clock I/O (público)
   void setClockIO(ClockIO io) { clockIO = io; }
   ClockIO getClockIO() const { return clockIO; }
   // Testa se uma entrada (inIndex 0..4) é permitida como fonte de clock
   bool isClockSourceEnabled(uint8_t inIndex) const;
+  // Transporte (Start/Stop/Continue/SPP) só é aceite da fonte primária
+  // (ou de qualquer fonte permitida enquanto não há primária)
+  bool acceptsTransportFrom(uint8_t inIndex) const;
+  uint8_t getPrimaryClockSource() const { return primarySource; }
+  uint32_t getClockFailovers() const { return clockFailovers; }
+  void resetClockFailovers() { clockFailovers = 0; }  // independente de resetJitterStats
+
+  // Clock por saída: taxa e desfasamento em ticks (positivo = atrasa os pulsos).
+  // Com x2 os meios ticks vêm do timer: em SLAVE só quando regenerado (em lock).
+  void setOutputClockRate(uint8_t outIndex, ClockRate rate);
+  ClockRate getOutputClockRate(uint8_t outIndex) const { return (ClockRate)outputClockRate[outIndex < NUM_CLOCK_OUTPUTS ? outIndex : 0]; }
+  void setOutputClockOffset(uint8_t outIndex, int8_t ticks);
+  int8_t getOutputClockOffset(uint8_t outIndex) const { return outputClockOffset[outIndex < NUM_CLOCK_OUTPUTS ? outIndex : 0]; }
+  // Testa se a saída deve emitir 0xF8 na posição 960 PPQN `pos`
+  bool isClockPulseDue(uint8_t outIndex, uint32_t pos) const;
+
+  // Modo do clock de saída em SLAVE (regenerado ou eco da entrada)
+  void setClockOutMode(ClockOutMode mode) { clockOutMode = mode; }
+  ClockOutMode getClockOutMode() const { return clockOutMode; }
+  // Jitter dos ticks gerados para as saídas (instante do tick no ISR/receção)
+  const ClockSourceStats& getOutputClockStats() const { return outputStats; }
   
-  // Getters para debug de jitter
-  uint16_t getMinClockInterval() const { return minClockInterval; }
-  uint16_t getMaxClockInterval() const { return maxClockInterval; }
-  unsigned long getLastClockInterval() const { return lastClockInterval; }
-  uint32_t getClockCount() const { return clockCount; }
+  // Estatísticas de jitter por fonte de clock
+  const ClockSourceStats& getClockSourceStats(uint8_t inIndex) const { return sources[inIndex < NUM_CLOCK_SOURCES ? inIndex : 0]; }
   void resetJitterStats();  // Reset dos contadores para nova medição
+
+  // Política de recuperação de ticks atrasados e monitorização da task do clock
+  void setCatchUpPolicy(CatchUpPolicy policy) { catchUpPolicy = policy; }
+  CatchUpPolicy getCatchUpPolicy() const { return catchUpPolicy; }
+  uint32_t getLateTicks() const { return lateTicks; }
+  uint32_t getDroppedLateTicks() const { return droppedLateTicks; }
+  uint32_t getTickBursts() const { return tickBursts; }
+  uint16_t getMaxTickBurst() const { return maxTickBurst; }
+  uint32_t getMaxTaskLatenessUs() const { return maxTaskLatenessUs; }
+  void resetTimingStats();
   
   // Triggerados internamente pelo timer
   void tickHandler();
   void startHandler();
   void stopHandler();
 
-  // Flags/contadores gerados no ISR e processados no contexto de loop
-  volatile uint16_t pendingClockTicks = 0;
-  volatile bool pendingStartFlag = false;
-  volatile bool pendingStopFlag = false;
-
   // Task handle para processamento dedicado do clock (FreeRTOS)
   TaskHandle_t clockTaskHandle = nullptr;
 
   // Loop da task que processa ticks pendentes (chamada pela FreeRTOS task)
   void clockTaskLoop();
 
-  // Processa envios pendentes gerados pelo ISR (deve ser chamado no contexto de loop())
+  // Consome o ring de eventos de tempo real (task do clock ou loop(), nunca ambos)
   void processPendingRealTime();
 };
 
@@ -0,0 +1,138 @@
+#ifndef MIDI_TX_SCHEDULER_H
+#define MIDI_TX_SCHEDULER_H
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include "MpscQueue.h"
+
+// Agendador de transmissão das portas DIN (31250 baud, ~3125 bytes/s).
+// Cada porta tem uma fila por prioridade: tempo real > Note Off > Note On >
+// MIDI thru > CC/feedback. O orçamento de cada porta é o próprio fio: cada
+// byte ocupa BYTE_US e uma classe só entrega bytes ao UART enquanto o que
+// ainda falta sair não passar o seu limite, para que um 0xF8 nunca espere
+// atrás de muitos bytes de menor prioridade já no FIFO do UART.
+// A divisão em classes e a fusão aplicam-se só ao tráfego do próprio engine
+// (sequenciador e feedback). O MIDI thru vai inteiro para uma fila FIFO
+// própria: PC, CC, pitch bend e notas de uma entrada saem pela ordem em que
+// chegaram, sem fusão.
+// Os CC/feedback pendentes são fundidos por (status, data1) e o mais antigo é
+// descartado em sobrecarga. Com a fila de notas ou de thru cheia a mensagem é
+// descartada e contada; quem envia nunca fica à espera do fio.
+// Os bytes de tempo real (0xF8..0xFF) não esperam pelo bombeamento: a task que
+// os envia escreve-os diretamente no UART (podem intercalar-se em qualquer
+// mensagem), para que um 0xF8 da task do clock nunca fique atrás de uma task
+// de menor prioridade que esteja a bombear.
+// Cada porta usa running status: mensagens de canal seguidas com o mesmo
+// status saem sem ele (até 1/3 menos bytes em sequências densas de notas).
+class MidiTxScheduler {
+public:
+  enum Priority : uint8_t {
+    PRIO_REALTIME = 0,   // clock, transporte e SPP
+    PRIO_NOTE_OFF,
+    PRIO_NOTE_ON,
+    PRIO_THRU,           // MIDI thru: FIFO, sem fusão (mantém a ordem da entrada)
+    PRIO_CC,             // CC, feedback e restantes mensagens de canal do engine
+    NUM_PRIORITIES
+  };
+
+  static const uint8_t NUM_PORTS = 3;
+  static const uint16_t BYTE_US = 320;            // 10 bits a 31250 baud
+  static const uint8_t NOTE_BACKLOG_BYTES = 9;    // máx. bytes de notas à frente de um 0xF8
+  static const uint8_t CC_BACKLOG_BYTES = 6;      // CC só entram com o fio quase livre
+  static const uint16_t RT_QUEUE_SIZE = 32;
+  static const uint16_t NOTE_QUEUE_SIZE = 64;
+  static const uint16_t THRU_QUEUE_SIZE = 64;
+  static const uint8_t CC_SLOTS = 32;
+  static const uint32_t RUNNING_STATUS_REFRESH_US = 500000;  // reenvia o status pelo menos a cada 0.5s
+
+  struct PortStats {
+    uint32_t bytesSent;
+    uint32_t overflows;   // mensagens que encontraram a fila cheia
+    uint32_t dropped;     // notas/thru descartadas por fila cheia
+    uint32_t thinned;     // CC/feedback fundidos com um pendente ou descartados
+    uint16_t peakDepth;   // maior número de mensagens em fila
+    uint32_t bytesSaved;  // bytes de status omitidos por running status
+  };
+
+  MidiTxScheduler();
+
+  void attachPort(uint8_t port, HardwareSerial* serial);
+
+  // Classe de uma mensagem do engine pelo status (Note On com velocity 0 conta
+  // como Note Off); o thru usa sempre PRIO_THRU
+  static Priority classify(uint8_t status, uint8_t data2);
+  // Número de bytes de uma mensagem com este status
+  static uint8_t messageLength(uint8_t status);
+
+  // Enfileira uma mensagem completa e bombeia; qualquer task, nunca bloqueia.
+  // Devolve false se a mensagem foi descartada (fila cheia; o CC mais antigo
+  // cede o lugar, por isso um CC é sempre aceite). Um byte de tempo real sai
+  // diretamente pela task que chama (fila só com o UART cheio ou com mensagens
+  // de sistema ainda à frente dele).
+  bool send(uint8_t port, Priority prio, uint8_t status, uint8_t data1, uint8_t data2);
+
+  // Entrega aos UARTs o que o orçamento de cada porta permite, por prioridade.
+  // Qualquer task: se outra já está a bombear, deixa-lhe o pedido e regressa.
+  void pump();
+
+  // Running status nas DIN (por omissão ligado)
+  void setRunningStatus(bool enabled);
+  // Envia Note Off como Note On com velocity 0 para sequências mais longas
+  // (perde a velocity de release; por omissão desligado)
+  void setNoteOffAsNoteOn(bool enabled);
+
+  bool hasPending() const;
+  uint16_t getQueueDepth(uint8_t port, Priority prio) const;
+  const PortStats& getStats(uint8_t port) const { return ports[port < NUM_PORTS ? port : 0].stats; }
+  void resetStats();
+
+private:
+  struct TxMessage {
+    uint8_t len;
+    uint8_t bytes[3];
+  };
+
+  struct Port {
+    HardwareSerial* serial = nullptr;
+    MpscQueue<TxMessage, RT_QUEUE_SIZE> realtime;
+    MpscQueue<TxMessage, NOTE_QUEUE_SIZE> noteOffs;
+    MpscQueue<TxMessage, NOTE_QUEUE_SIZE> noteOns;
+    MpscQueue<TxMessage, THRU_QUEUE_SIZE> thru;
+    // CC/feedback: FIFO curto com fusão, protegido por ccMux
+    TxMessage cc[CC_SLOTS];
+    uint8_t ccCount = 0;
+    portMUX_TYPE ccMux = portMUX_INITIALIZER_UNLOCKED;
+    // Note Ons em fila por (canal, nota) com hash: um Note Off cuja nota ainda
+    // não saiu segue atrás dela, na fila dos Note Ons (nunca a ultrapassa)
+    std::atomic<uint8_t> queuedOns[256];
+    uint32_t busyUntilUs = 0;   // instante em que o fio acaba os bytes já entregues
+    // Bytes de tempo real escritos diretamente por quem os envia, ainda não
+    // contados em busyUntilUs/stats (o bombeamento soma-os)
+    std::atomic<uint32_t> directBytes{0};
+    // Running status: último status de canal enviado (0 = nenhum)
+    bool runningStatusEnabled = true;
+    bool noteOffAsNoteOn = false;
+    uint8_t runningStatus = 0;
+    uint32_t runningStatusSentUs = 0;
+    PortStats stats = {0, 0, 0, 0, 0, 0};
+  };
+
+  // Canal e nota (Note On e Off da mesma nota têm o mesmo hash)
+  static uint8_t noteHash(const TxMessage& m) { return (uint8_t)(m.bytes[1] + (m.bytes[0] & 0x0F) * 131); }
+  bool pushNote(Port& p, MpscQueue<TxMessage, NOTE_QUEUE_SIZE>& q, const TxMessage& m);
+  void pushCC(Port& p, const TxMessage& m);
+  // Byte de tempo real escrito já no UART, fora do bombeamento; false se tiver de ir para a fila
+  bool writeRealTimeDirect(Port& p, uint8_t status);
+  // Entrega `m` ao UART se couber no limite da classe; false se tiver de esperar
+  bool writeMessage(Port& p, const TxMessage& m, uint32_t nowUs, uint8_t limitBytes);
+  void pumpPort(Port& p, uint32_t nowUs);
+  uint16_t totalDepth(const Port& p) const;
+
+  Port ports[NUM_PORTS];
+  std::atomic<uint32_t> pumpRequests{0};
+  std::atomic<bool> pumpBusy{false};
+};
+
+#endif // MIDI_TX_SCHEDULER_H
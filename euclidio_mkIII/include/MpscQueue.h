@@ -0,0 +1,89 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Fila limitada lock-free com vários produtores e um consumidor (Vyukov).
+// Cada célula tem um número de sequência: os produtores reservam uma posição
+// com CAS e publicam-na ao escrever a sequência; o consumidor só lê células
+// já publicadas. Sem locks nem secções críticas. N tem de ser potência de 2.
+template <typename T, uint16_t N>
+class MpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue: N tem de ser potência de 2");
+
+public:
+  MpscQueue() : enqueuePos(0), dequeuePos(0) {
+    for (uint16_t i = 0; i < N; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  // Qualquer task. Devolve false se a fila estiver cheia.
+  bool push(const T& value) {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells[pos & (N - 1)];
+      uint32_t seq = cell->seq.load(std::memory_order_acquire);
+      int32_t dif = (int32_t)(seq - pos);
+      if (dif == 0) {
+        // Célula livre nesta volta: tenta reservá-la
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (dif < 0) {
+        return false;  // cheia: o consumidor ainda não libertou a célula
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = value;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Apenas o consumidor. Devolve false se não houver evento publicado.
+  bool pop(T& out) {
+    uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell = &cells[pos & (N - 1)];
+    uint32_t seq = cell->seq.load(std::memory_order_acquire);
+    if ((int32_t)(seq - (pos + 1)) < 0) return false;
+    out = cell->data;
+    // Liberta a célula para a volta seguinte dos produtores
+    cell->seq.store(pos + N, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Apenas o consumidor: próximo elemento publicado sem o retirar (nullptr se vazia)
+  const T* front() const {
+    uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+    const Cell* cell = &cells[pos & (N - 1)];
+    if ((int32_t)(cell->seq.load(std::memory_order_acquire) - (pos + 1)) < 0) return nullptr;
+    return &cell->data;
+  }
+
+  // Qualquer task (aproximado fora do consumidor)
+  bool empty() const {
+    uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+    const Cell* cell = &cells[pos & (N - 1)];
+    return (int32_t)(cell->seq.load(std::memory_order_acquire) - (pos + 1)) < 0;
+  }
+
+  // Qualquer task; aproximado com produtores/consumidor concorrentes
+  uint16_t size() const {
+    uint32_t deq = dequeuePos.load(std::memory_order_relaxed);
+    int32_t n = (int32_t)(enqueuePos.load(std::memory_order_relaxed) - deq);
+    if (n < 0) return 0;
+    return (uint16_t)(n > N ? N : n);
+  }
+
+private:
+  struct Cell {
+    std::atomic<uint32_t> seq;
+    T data;
+  };
+
+  Cell cells[N];
+  std::atomic<uint32_t> enqueuePos;
+  std::atomic<uint32_t> dequeuePos;   // escrito só pelo consumidor; atómico para size()/empty() dos produtores
+};
+
+#endif // MPSC_QUEUE_H
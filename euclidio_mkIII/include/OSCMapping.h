@@ -35,7 +35,18 @@ public:
 	
 	static const char* PATH_PLAYSTOP;
 	static const char* PATH_TEMPO;
+	static const char* PATH_TEMPO_RAMP;
+	static const char* PATH_LOCATE;
+	static const char* PATH_CLOCK_RATE;
+	static const char* PATH_CLOCK_OFFSET;
 	static const char* PATH_NOTE_LENGTH;
+	static const char* PATH_GATE;
+	static const char* PATH_ALGORITHM;
+	static const char* PATH_PROBABILITY;
+	static const char* PATH_RATCHET;
+	static const char* PATH_CHANCE_STEP;
+	static const char* PATH_RATCHET_STEP;
+	static const char* PATH_SEED;
 	// Base path for dub per-track mapping: clients should use /sequencer/dub/<n>
 	static const char* PATH_DUB_BASE;
 
@@ -51,6 +62,8 @@ public:
 	static const char* PATH_HARMONIC_POLY;
 	static const char* PATH_HARMONIC_VELOCITY;
 	static const char* PATH_HARMONIC_NOTE_LENGTH;
+	static const char* PATH_HARMONIC_GATE;
+	static const char* PATH_HARMONIC_ALGORITHM;
 	static const char* PATH_HARMONIC_OCTAVE;
 	static const char* PATH_HARMONIC_ACTIVE;
 	static const char* PATH_HARMONIC_TRACK;
@@ -87,7 +100,7 @@ private:
 	static uint8_t lastTrack;
 	static bool lastPlayState;
 	static float lastTempo;
-	static bool lastDubState[8];
+	static uint64_t lastDubMask;  // bit por track (até 64)
 	static uint16_t lastNoteLength;
 
 	// Harmonic sequencer last-value caches (to send per-parameter feedback)
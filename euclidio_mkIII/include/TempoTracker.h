@@ -0,0 +1,58 @@
+#ifndef TEMPO_TRACKER_H
+#define TEMPO_TRACKER_H
+
+#include <stdint.h>
+
+// Estimador de tempo/fase (PLL por software) para clock MIDI externo.
+// Alisa os intervalos entre 0xF8 recebidos, deteta clocks perdidos ou
+// duplicados e fornece o período corrigido em fase para o timer interno.
+// Corre apenas em contexto de task/loop (usa float).
+class TempoTracker {
+public:
+  static const uint8_t PPQN = 24;
+  static const uint8_t LOCK_CLOCKS = 6;        // intervalos consistentes necessários para lock
+  static const uint8_t MAX_MISSING_CLOCKS = 3; // clocks perdidos tolerados num só intervalo
+
+  TempoTracker();
+
+  void reset();
+
+  // Regista um clock externo recebido em `nowUs`.
+  // Devolve quantos ticks este clock representa: 0 = duplicado (ignorado),
+  // 1 = normal, >1 = clocks perdidos pelo caminho.
+  uint8_t onClock(uint32_t nowUs);
+
+  // Período a aplicar no próximo tick interno, dado o erro de fase em ticks
+  // (positivo = gerador atrasado em relação à fonte externa).
+  float correctedPeriodUs(float phaseErrorTicks);
+
+  bool isLocked() const { return locked; }
+  float getPeriodUs() const { return periodUs; }
+  float getBPM() const { return (periodUs > 0.0f) ? 60000000.0f / (periodUs * PPQN) : 0.0f; }
+  uint32_t getLastClockTime() const { return lastClockUs; }
+
+  // Estatísticas (debug)
+  uint32_t getMissingClocks() const { return missingClocks; }
+  uint32_t getDoubledClocks() const { return doubledClocks; }
+
+private:
+  static constexpr float ALPHA = 0.0625f;      // peso do EMA do período
+  static constexpr float KP = 0.05f;           // ganho proporcional da correção de fase
+  static constexpr float MAX_CORRECTION = 0.05f;
+  static constexpr float LOCK_TOLERANCE = 0.25f;
+  static const uint8_t ANOMALY_UNLOCK_SCORE = 8;
+
+  // Conta uma anomalia (clock perdido/duplicado); devolve true se causou perda de lock
+  bool registerAnomaly();
+
+  float periodUs;
+  uint32_t lastClockUs;
+  bool hasLast;
+  bool locked;
+  uint8_t consistentCount;
+  uint8_t anomalyScore;
+  uint32_t missingClocks;
+  uint32_t doubledClocks;
+};
+
+#endif // TEMPO_TRACKER_H
@@ -0,0 +1,59 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <stdint.h>
+
+// Roda temporal hierárquica (2 níveis) para eventos diferidos, p.ex. note-offs.
+// Nível 0: 256 slots de 250µs (64ms); nível 1: 256 slots de 64ms (~16s).
+// Inserção e expiração O(1) sobre um pool fixo de nós (sem alocações).
+// Não é thread-safe: quem a partilha entre tasks protege as chamadas.
+class TimingWheel {
+public:
+  static const uint32_t TICK_US = 250;
+  static const uint16_t SLOTS = 256;
+  static const uint16_t MAX_EVENTS = 2048;
+
+  TimingWheel();
+
+  void reset(uint32_t nowUs);
+
+  // Agenda `payload` para `nowUs + delayUs`. Atrasos acima do alcance do
+  // nível 1 são limitados. Devolve false se o pool estiver cheio.
+  bool schedule(uint32_t nowUs, uint32_t delayUs, uint32_t payload);
+
+  // Avança até `nowUs` e copia para `out` os payloads expirados (máx. `maxOut`).
+  // Se `out` encher, os restantes ficam para a próxima chamada.
+  uint16_t advance(uint32_t nowUs, uint32_t* out, uint16_t maxOut);
+
+  uint16_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  uint32_t getDroppedEvents() const { return droppedEvents; }
+  uint16_t getPeakSize() const { return peakCount; }
+
+private:
+  static const uint16_t NIL = 0xFFFF;
+
+  struct Node {
+    uint32_t expiry;   // tick absoluto da roda
+    uint32_t payload;
+    uint16_t next;
+  };
+
+  void insertNode(uint16_t idx);
+  // Move os nós do slot de nível 1 atual para o nível 0
+  void cascade();
+  // Copia para `out` os nós do slot de nível 0 atual (todos expirados)
+  uint16_t drainCurrentSlot(uint32_t* out, uint16_t maxOut);
+
+  Node nodes[MAX_EVENTS];
+  uint16_t level0[SLOTS];
+  uint16_t level1[SLOTS];
+  uint16_t freeHead;
+  uint16_t count;
+  uint16_t peakCount;
+  uint32_t currentTick;   // tick atual (contador próprio, imune ao wrap de micros)
+  uint32_t tickStartUs;   // micros() em que o tick atual começou
+  uint32_t droppedEvents;
+};
+
+#endif // TIMING_WHEEL_H
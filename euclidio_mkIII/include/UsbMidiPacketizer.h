@@ -0,0 +1,83 @@
+#ifndef USB_MIDI_PACKETIZER_H
+#define USB_MIDI_PACKETIZER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+
+class Adafruit_USBD_MIDI;
+
+// Empacotador de saída USB-MIDI: cada mensagem vira um pacote de 4 bytes
+// (cabo/Code Index Number + 3 bytes MIDI) acumulado num buffer de transferência.
+// Cada produtor esvazia-o ao fim do seu ciclo (ou quando chega a um transfer
+// bulk completo), em vez de uma chamada ao TinyUSB por byte; um evento nunca
+// fica partido entre frames USB.
+// Os bytes de tempo real saem diretamente pela task que os envia (um pacote
+// isolado no FIFO do TinyUSB), para que um 0xF8 da task do clock nunca espere
+// por uma task de menor prioridade que esteja a esvaziar o buffer.
+// Os últimos NOTE_OFF_RESERVE lugares do buffer ficam para Note Off e
+// mensagens de sistema; com o buffer cheio estas tiram o lugar ao CC mais
+// antigo (depois ao Note On), que são sempre os primeiros descartados.
+// Pacotes que o FIFO do TinyUSB não aceitou voltam ao buffer em vez de
+// serem descartados.
+class UsbMidiPacketizer {
+public:
+  static const uint8_t CABLE = 0;
+  static const uint8_t FLUSH_PACKETS = 16;    // 64 bytes: um transfer bulk full-speed
+  static const uint8_t BUFFER_PACKETS = 32;   // folga enquanto outra task esvazia
+  static const uint8_t NOTE_OFF_RESERVE = 8;  // lugares só para Note Off e sistema
+
+  struct Stats {
+    uint32_t flushes;
+    uint32_t packets;
+    uint16_t maxPacketsPerFlush;
+    uint32_t lastFlushLatencyUs;   // primeiro pacote acumulado -> entregue ao TinyUSB
+    uint32_t maxFlushLatencyUs;
+    uint32_t droppedPackets;       // buffer cheio (CC/Note On antes de Note Off)
+    uint32_t realtimeDirect;       // bytes de tempo real entregues sem passar pelo buffer
+  };
+
+  void begin(Adafruit_USBD_MIDI* usb) { usb_midi = usb; }
+
+  // Code Index Number USB-MIDI 1.0 para uma mensagem com este status
+  static uint8_t codeIndex(uint8_t status);
+
+  // Acrescenta uma mensagem completa ao buffer; qualquer task
+  void write(uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0);
+  // Byte de tempo real (0xF8..0xFF): sai já, sem esperar por quem estiver a
+  // esvaziar. Vai pelo buffer (e esvazia-o) só com o FIFO do TinyUSB cheio ou
+  // com mensagens de sistema ainda à frente dele (ex.: SPP antes do Continue).
+  void writeRealTime(uint8_t status);
+
+  // Entrega ao TinyUSB os pacotes acumulados; qualquer task. Se outra já está
+  // a esvaziar, deixa-lhe o pedido e regressa (a ordem dos pacotes mantém-se).
+  void flush();
+
+  float getAveragePacketsPerFlush() const { return stats.flushes ? (float)stats.packets / stats.flushes : 0.0f; }
+  const Stats& getStats() const { return stats; }
+  void resetStats();
+
+private:
+  // Note Off (ou Note On com velocity 0) num pacote já montado
+  static bool isNoteOffPacket(const uint8_t* p) {
+    return (p[0] & 0x0F) == 0x08 || ((p[0] & 0x0F) == 0x09 && p[3] == 0);
+  }
+  // Retira de `buf` o CC mais antigo (ou o Note On mais antigo, sem CC);
+  // false se só há Note Off e mensagens de sistema
+  static bool evictDroppable(uint8_t (*buf)[4], uint8_t& n);
+  // Devolve ao início do buffer os pacotes que o TinyUSB não aceitou
+  void requeue(const uint8_t (*batch)[4], uint8_t n, uint32_t firstUs);
+
+  Adafruit_USBD_MIDI* usb_midi = nullptr;
+  uint8_t packets[BUFFER_PACKETS][4];
+  uint8_t count = 0;
+  uint32_t firstPacketUs = 0;
+  portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+  std::atomic<uint32_t> flushRequests{0};
+  std::atomic<bool> flushBusy{false};
+  // Mensagens de sistema no buffer ou num lote ainda por entregar
+  std::atomic<uint8_t> systemPending{0};
+  Stats stats = {0, 0, 0, 0, 0, 0, 0};
+};
+
+#endif // USB_MIDI_PACKETIZER_H
@@ -350,9 +350,9 @@ void EncoderHandler_handle() {
             break;
           }
           case 6:
-            harmonicSeq.setSteps(constrain((int)harmonicSeq.getSteps() + dir, 1, 32)); break;
+            harmonicSeq.setSteps(EuclideanPatterns::clampSteps((int)harmonicSeq.getSteps() + dir)); break;
           case 7:
-            harmonicSeq.setHits(constrain((int)harmonicSeq.getHits() + dir, 1, 32)); break;
+            harmonicSeq.setHits(EuclideanPatterns::clampHits((int)harmonicSeq.getHits() + dir)); break;
           case 8:
             harmonicSeq.setOffset((harmonicSeq.getOffset() + dir + harmonicSeq.getSteps()) % harmonicSeq.getSteps()); break;
           case 9:
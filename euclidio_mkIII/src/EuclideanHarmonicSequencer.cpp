@@ -1,6 +1,7 @@
 #include "EuclideanHarmonicSequencer.h"
 #include "EuclideanMidiEngine.h"
 #include "MidiClock.h"
+#include "EuclideanPatterns.h"
 #include <algorithm>
 // Feedback helpers
 #include "MidiFeedback.h"
@@ -74,8 +75,8 @@ EuclideanHarmonicSequencer::EuclideanHarmonicSequencer()
   for (uint8_t t = 0; t < EuclideanHarmonicSequencer::MAX_TRACKS; ++t) {
     patternLen[t] = 0;
     chordListSize[t] = 0;
+    lastStepPerTrack[t] = 255;
   }
-  pendingOffsCount = 0;
   pendingFeedback = false;
   resetToDefaults();
 }
@@ -96,6 +97,10 @@ void EuclideanHarmonicSequencer::resetToDefaults() {
     distributionMode[t] = DIST_CHORDS;
     scaleType[t] = (int)EuclideanHarmonicSequencer::SCALE_MAJOR;
     resolutionIndex[t] = 1;
+    outputPorts[t] = EuclideanSequencer::PORT_ALL;
+    gateMode[t] = EuclideanSequencer::GATE_MS;
+    gateAmount[t] = EuclideanSequencer::DEFAULT_GATE_AMOUNT;
+    algorithm[t] = EuclideanPatterns::ALGO_ANCHORED;
     chordListPos[t] = 0;
     // All tracks start OFF (not audible)
     enabled[t] = false;
@@ -116,7 +121,6 @@ void EuclideanHarmonicSequencer::resetToDefaults() {
   running = false;
   currentStep = 0;
   lastStep = 255;
-  pendingOffsCount = 0;
 }
 
 // Track handling
@@ -163,7 +167,6 @@ void EuclideanHarmonicSequencer::getAllowedDegrees(std::vector<uint8_t> &out) co
 void EuclideanHarmonicSequencer::begin(EuclideanMidiEngine* eng, MidiClock* clock) {
   engine = eng;
   midiClock = clock;
-  pendingOffsCount = 0;
   // Persistence disabled: operate in RAM only (no loading from flash)
   // All tracks começam e permanecem em OFF (não audíveis)
   for (uint8_t t = 0; t < MAX_TRACKS; ++t) {
@@ -197,18 +200,20 @@ void EuclideanHarmonicSequencer::start() {
   // Garante que o ciclo sempre começa no primeiro acorde da lista
   for (uint8_t t = 0; t < MAX_TRACKS; ++t) {
     chordListPos[t] = 0;
+    lastStepPerTrack[t] = 255;
   }
 }
 void EuclideanHarmonicSequencer::stop() { running = false; }
 void EuclideanHarmonicSequencer::reset() { currentStep = 0; lastStep = 255; }
 
 void EuclideanHarmonicSequencer::setSteps(uint8_t s) {
-  steps[activeTrack] = (s==0?1:s);
+  // same limits as the Euclidean sequencer (1..EuclideanPatterns::MAX_STEPS)
+  steps[activeTrack] = EuclideanPatterns::clampSteps(s);
   patternDirty[activeTrack] = true;
   patternLastEditTime[activeTrack] = millis();
 }
 void EuclideanHarmonicSequencer::setHits(uint8_t h) {
-  hits[activeTrack] = (h==0?1:h);
+  hits[activeTrack] = EuclideanPatterns::clampHits(h);
   patternDirty[activeTrack] = true;
   patternLastEditTime[activeTrack] = millis();
 }
@@ -217,6 +222,11 @@ void EuclideanHarmonicSequencer::setOffset(uint8_t o) {
   patternDirty[activeTrack] = true;
   patternLastEditTime[activeTrack] = millis();
 }
+void EuclideanHarmonicSequencer::setAlgorithm(uint8_t algo) {
+  algorithm[activeTrack] = EuclideanPatterns::clampAlgorithm(algo);
+  patternDirty[activeTrack] = true;
+  patternLastEditTime[activeTrack] = millis();
+}
 void EuclideanHarmonicSequencer::setTonic(uint8_t t) { tonic[activeTrack] = t % 12; }
 void EuclideanHarmonicSequencer::setScaleMajor(bool major) { majorScale[activeTrack] = major; }
 void EuclideanHarmonicSequencer::setBaseOctave(int8_t oct) { baseOctave[activeTrack] = (int8_t)constrain((int)oct, -2, 2); }
@@ -233,52 +243,25 @@ void EuclideanHarmonicSequencer::generatePatternForTrack(uint8_t t) {
   bool buf[EuclideanHarmonicSequencer::MAX_STEPS];
   // ensure buffer large enough
   if (s > EuclideanHarmonicSequencer::MAX_STEPS) s = EuclideanHarmonicSequencer::MAX_STEPS;
-  bjorklundStatic(buf, s, hits[t], offset[t], EuclideanHarmonicSequencer::MAX_STEPS);
+  bjorklundStatic(buf, s, hits[t], offset[t], EuclideanHarmonicSequencer::MAX_STEPS, algorithm[t]);
   // copy into static pattern buffer
   patternLen[t] = s;
   for (uint8_t i = 0; i < s; ++i) pattern[t][i] = buf[i];
   // clear remaining
   for (uint8_t i = s; i < EuclideanHarmonicSequencer::MAX_STEPS; ++i) pattern[t][i] = false;
+  // prefix hit counts so relocate() can restore chordListPos without scanning the pattern
+  hitsBefore[t][0] = 0;
+  for (uint8_t i = 0; i < EuclideanHarmonicSequencer::MAX_STEPS; ++i) {
+    hitsBefore[t][i + 1] = hitsBefore[t][i] + (pattern[t][i] ? 1 : 0);
+  }
 }
-void EuclideanHarmonicSequencer::bjorklundAlgorithm(std::vector<bool> &out, uint8_t s, uint8_t h, uint8_t off) {
-  // Compatibility wrapper: uses allocation-free implementation internally
-  if (s == 0) return;
-  if (s > EuclideanHarmonicSequencer::MAX_STEPS) s = EuclideanHarmonicSequencer::MAX_STEPS;
-  bool buf[EuclideanHarmonicSequencer::MAX_STEPS];
-  bjorklundStatic(buf, s, h, off, EuclideanHarmonicSequencer::MAX_STEPS);
-  out.clear();
-  out.resize(s);
-  for (uint8_t i = 0; i < s; ++i) out[i] = buf[i];
-}
-
-void EuclideanHarmonicSequencer::bjorklundStatic(bool *out, uint8_t s, uint8_t h, uint8_t off, uint8_t max_len) {
+void EuclideanHarmonicSequencer::bjorklundStatic(bool *out, uint8_t s, uint8_t h, uint8_t off, uint8_t max_len, uint8_t algo) {
   if (!out || max_len == 0) return;
   if (s == 0) return;
   if (s > max_len) s = max_len;
-  if (h > s) h = s;
-  if (h == 0) {
-    for (uint8_t i = 0; i < s; ++i) out[i] = false;
-    return;
-  }
-  if (h == s) {
-    for (uint8_t i = 0; i < s; ++i) out[i] = true;
-    return;
-  }
-  // Simple, deterministic distribution: (i*h) mod s < h
-  for (uint8_t i = 0; i < s; ++i) {
-    out[i] = ((((uint16_t)i * h) % s) < h);
-  }
-  // rotation (offset)
-  uint8_t roff = off % s;
-  if (roff != 0) {
-    // perform in-place rotation using a small temp buffer on stack
-    bool temp[EuclideanHarmonicSequencer::MAX_STEPS];
-    for (uint8_t i = 0; i < s; ++i) {
-      uint8_t src = (i + s - roff) % s;
-      temp[i] = out[src];
-    }
-    for (uint8_t i = 0; i < s; ++i) out[i] = temp[i];
-  }
+  // Table lookup plus bit rotation (offset); no per-edit generation
+  uint64_t mask = EuclideanPatterns::get(s, h, off, EuclideanPatterns::clampAlgorithm(algo));
+  for (uint8_t i = 0; i < s; ++i) out[i] = (mask >> i) & 1;
 }
 
 uint8_t EuclideanHarmonicSequencer::scaleDegreeToMidi(uint8_t degree, int8_t octaveShift) const {
@@ -336,26 +319,43 @@ void EuclideanHarmonicSequencer::triggerChord(uint8_t degreeIndex) {
   }
 
   uint16_t nl = noteLength[activeTrack];
+  // Gate measured from this note-on, at the current tick period
+  uint32_t gateUs = engine->gateLengthUs(gateMode[activeTrack], gateAmount[activeTrack], nl,
+                                         ticksPerStepForTrack(activeTrack));
   uint8_t ch = midiChannel[activeTrack] & 0x0F;
   uint8_t vel = velocity[activeTrack];
-  if (distributionMode[activeTrack] == DIST_CHORDS) {
-    for (uint8_t i = 0; i < outNotesCount; ++i) {
-      engine->enqueueNoteEvent(ch, outNotesArr[i], vel, nl, true);
-      PendingOff po{outNotesArr[i], ch, (uint32_t)millis() + nl};
-      if (pendingOffsCount < EuclideanHarmonicSequencer::MAX_PENDING_OFFS) {
-        pendingOffs[pendingOffsCount++] = po;
-      }
-    }
-  } else {
-    // NOTES: send only the root
-    engine->enqueueNoteEvent(ch, outNotesArr[0], vel, nl, true);
-    PendingOff po{outNotesArr[0], ch, (uint32_t)millis() + nl};
-    if (pendingOffsCount < EuclideanHarmonicSequencer::MAX_PENDING_OFFS) {
-      pendingOffs[pendingOffsCount++] = po;
-    }
+  uint8_t ports = outputPorts[activeTrack];
+  if (ports == 0) return;
+  // The event carries its track and gate all the way to the output
+  EuclideanMidiEngine::NoteEvent evt;
+  evt.timestampUs = micros();
+  evt.gateUs = gateUs;
+  evt.channel = ch;
+  evt.velocity = vel;
+  evt.ports = ports;
+  evt.track = activeTrack;
+  evt.source = EuclideanMidiEngine::SOURCE_HARMONIC;
+  evt.isNoteOn = true;
+  // NOTES mode sends only the root
+  uint8_t count = (distributionMode[activeTrack] == DIST_CHORDS) ? outNotesCount : 1;
+  for (uint8_t i = 0; i < count; ++i) {
+    evt.note = outNotesArr[i];
+    engine->emitNote(evt);
   }
 }
 
+void EuclideanHarmonicSequencer::setGateMode(uint8_t mode) {
+  if (mode >= EuclideanSequencer::GATE_MODE_COUNT) return;
+  gateMode[activeTrack] = mode;
+  // keep the amount within the range of the new mode
+  setGateAmount(gateAmount[activeTrack]);
+}
+
+void EuclideanHarmonicSequencer::setGateAmount(uint8_t amount) {
+  uint8_t maxAmount = (gateMode[activeTrack] == EuclideanSequencer::GATE_PERCENT) ? 100 : EuclideanSequencer::MAX_GATE_TICKS;
+  gateAmount[activeTrack] = constrain(amount, (uint8_t)1, maxAmount);
+}
+
 void EuclideanHarmonicSequencer::fillChordListFromScale() {
   // fill for activeTrack
   chordListSize[activeTrack] = 0;
@@ -461,6 +461,27 @@ void EuclideanHarmonicSequencer::getChordName(uint8_t chordIndex, char* out, siz
     }
   }
 
+uint16_t EuclideanHarmonicSequencer::ticksPerStepForTrack(uint8_t t) const {
+  // Res 0..2 (1/4, 1/8, 1/16) uses the same entries as Euclidean resolution 1..3
+  return EuclideanMidiEngine::ticksPerResolution[resolutionIndex[t] % 3];
+}
+
+void EuclideanHarmonicSequencer::relocate(uint32_t tick) {
+  for (uint8_t t = 0; t < MAX_TRACKS; ++t) {
+    uint16_t ticksPerStep = ticksPerStepForTrack(t);
+    uint8_t s = steps[t];
+    if (s == 0) s = 1;
+    uint8_t step = (tick / ticksPerStep) % s;
+    // At a step boundary the step is replayed on the next tick; mid-step it counts as played
+    bool atBoundary = (tick % ticksPerStep) == 0;
+    lastStepPerTrack[t] = atBoundary ? 255 : step;
+    currentStepPerTrack[t] = step;
+    uint8_t played = (step < patternLen[t]) ? hitsBefore[t][atBoundary ? step : step + 1] : hitsBefore[t][patternLen[t]];
+    chordListPos[t] = chordListSize[t] ? (uint8_t)(played % chordListSize[t]) : 0;
+  }
+  currentStep = currentStepPerTrack[activeTrack];
+}
+
 void EuclideanHarmonicSequencer::update() {
   if (!midiClock) return;
 
@@ -471,21 +492,7 @@ void EuclideanHarmonicSequencer::update() {
     OSCMapping::sendAllHarmonicFeedbackForced(this, midiClock);
   }
 
-  // Process pending offs
-  uint32_t now = millis();
-  if (pendingOffsCount > 0) {
-    uint8_t write = 0;
-    for (uint8_t read = 0; read < pendingOffsCount; ++read) {
-      PendingOff &p = pendingOffs[read];
-      if ((int32_t)(now - p.time) >= 0) {
-        if (engine) engine->enqueueNoteEvent(p.channel, p.note, 0, 0, false);
-      } else {
-        if (write != read) pendingOffs[write] = pendingOffs[read];
-        ++write;
-      }
-    }
-    pendingOffsCount = write;
-  }
+  // Note-offs are scheduled into the engine's timing wheel (see triggerChord)
 
   // Process deferred pattern generation even if sequencer not running
   unsigned long nowMs = millis();
@@ -502,18 +509,15 @@ void EuclideanHarmonicSequencer::update() {
 
   // calcular passo atual baseado no MidiClock ticks
   uint32_t globalTicks = midiClock->getTickCount();
-  // escolher ticks por step baseado no parâmetro Res: 1/4, 1/8, 1/16
-  const uint16_t ticksPerRes[] = { 24, 12, 6 }; // PPQN ticks per harmonic step for 1/4,1/8,1/16
   // Para todas as tracks ativas, calcular passo e disparar acorde se necessário
   for (uint8_t t = 0; t < MAX_TRACKS; ++t) {
     if (!enabled[t]) continue;
-    uint8_t ridx = resolutionIndex[t] % 3;
-    uint16_t ticksPerStep = ticksPerRes[ridx];
+    // ticks por step baseado no parâmetro Res: 1/4, 1/8, 1/16
+    uint16_t ticksPerStep = ticksPerStepForTrack(t);
     uint8_t s = steps[t];
     if (s == 0) s = 1;
     uint8_t step = (globalTicks / ticksPerStep) % s;
     // Só dispara se mudou de step para esta track
-    static uint8_t lastStepPerTrack[MAX_TRACKS] = {255,255,255,255,255,255,255,255};
     if (step != lastStepPerTrack[t]) {
       lastStepPerTrack[t] = step;
       // Reset no início de cada ciclo para tocar sempre do primeiro acorde
@@ -5,7 +5,6 @@
 // FreeRTOS for worker task
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/semphr.h>
 
 // Tabela de ticks por resolução
 const uint8_t EuclideanMidiEngine::ticksPerResolution[4] = {24, 12, 6, 3};
@@ -13,24 +12,16 @@ const uint8_t EuclideanMidiEngine::ticksPerResolution[4] = {24, 12, 6, 3};
 // Instance global para acessar métodos via function pointers
 static EuclideanMidiEngine* g_euclidMidiEngine = nullptr;
 
-// Wrappers estáticos para callbacks (apenas stepStart é necessário)
-void euclidStepStartWrapper(uint8_t step) {
-	if (g_euclidMidiEngine) g_euclidMidiEngine->onStepStart(step);
-}
-
 void EuclideanMidiEngine::begin(EuclideanSequencer* seq, MidiClock* clk,
 								 Adafruit_USBD_MIDI* usb) {
 	euclSeq = seq;
 	clock = clk;
 	usb_midi = usb;
 	
-	// Inicializa cache e fila de Note Offs
-	for (uint8_t i = 0; i < 8; ++i) {
-		pendingNoteOffs[i].pending = false;
-		pendingNoteOffs[i].note = 0;
-		pendingNoteOffs[i].channel = 0;
-		pendingNoteOffs[i].time = 0;
-	}
+	// Inicializa roda de Note Offs
+	portENTER_CRITICAL(&noteOffMux);
+	noteOffWheel.reset(micros());
+	portEXIT_CRITICAL(&noteOffMux);
 	
 	// Guarda instância global para callbacks
 	g_euclidMidiEngine = this;
@@ -44,13 +35,10 @@ void EuclideanMidiEngine::begin(EuclideanSequencer* seq, MidiClock* clk,
 		};
 	}
 	
-	// Registra callbacks do clock
-	registerClockCallbacks();
+	// Ticks chegam por MIDIRouter::clockTickCallback (onClockTick)
+	resetRender(0);
 
-	// Cria semáforo e tarefa worker para processar a fila de MIDI
-	if (!midiQueueSem) {
-		midiQueueSem = xSemaphoreCreateCounting(MIDI_QUEUE_SIZE, 0);
-	}
+	// Cria tarefa worker para processar a fila de MIDI
 	if (!midiWorkerHandle) {
 		// Dar prioridade alta ao envio de USB MIDI (logo abaixo do clock)
 		UBaseType_t maxPriority = configMAX_PRIORITIES - 1;
@@ -68,61 +56,128 @@ void EuclideanMidiEngine::begin(EuclideanSequencer* seq, MidiClock* clk,
 
 // ===== FILA UNIFICADA PARA USB MIDI =====
 
-void EuclideanMidiEngine::enqueueMidiEvent(uint8_t channel, uint8_t note, uint8_t velocity, uint16_t noteLength, bool isNoteOn) {
-	uint16_t nextHead = (midiQueueHead + 1) % MIDI_QUEUE_SIZE;
-	
-	if (nextHead == midiQueueTail) {
+void EuclideanMidiEngine::enqueueMidiEvent(const NoteEvent& evt) {
+	if (!midiQueue.push(evt)) {
 		midiDroppedEvents++;
 		return;
 	}
-	
-	midiQueue[midiQueueHead].channel = channel & 0x0F;
-	midiQueue[midiQueueHead].note = note & 0x7F;
-	// Velocity já é 0-127, apenas garantir range
-	midiQueue[midiQueueHead].velocity = constrain(velocity, 0, 127);
-	midiQueue[midiQueueHead].noteLength = constrain(noteLength, 50, 700);  // Validar range 50-700
-	midiQueue[midiQueueHead].isNoteOn = isNoteOn;
-	midiQueueHead = nextHead;
+	wakeWorker();
+}
 
-	// Sinaliza ao worker que há um evento novo
-	if (midiQueueSem) {
-		xSemaphoreGive(midiQueueSem);
+void EuclideanMidiEngine::wakeWorker() {
+	// Acorda o worker apenas se estiver a dormir: uma notificação por lote
+	if (workerWaiting.exchange(false) && midiWorkerHandle) {
+		xTaskNotifyGive(midiWorkerHandle);
 	}
 }
 
 void EuclideanMidiEngine::processMidiQueue() {
-	while (midiQueueHead != midiQueueTail) {
-		MidiEvent& evt = midiQueue[midiQueueTail];
-		uint8_t statusByte = (evt.isNoteOn ? 0x90 : 0x80) | (evt.channel & 0x0F);
-		
-		// Enviar baseado no protocolo selecionado
-		// Enviar baseado no protocolo selecionado (respeita a seleção Note Out)
-		uint8_t outs = 0x0F; // default all
-		if (euclSeq) outs = (uint8_t)euclSeq->getOutputNotes();
-		// USB
-		if ((outs & EuclideanSequencer::OUT_USB) && usb_midi) {
-			usb_midi->write(statusByte);
-			usb_midi->write(evt.note);
-			usb_midi->write(evt.velocity);
+	NoteEvent evt;
+	uint8_t outs = 0x0F; // default all
+	if (euclSeq) outs = (uint8_t)euclSeq->getOutputNotes();
+	while (midiQueue.pop(evt)) {
+		bool noteOn = evt.isNoteOn && evt.velocity > 0;
+		if (noteOn && evt.source < NUM_SOURCES && evt.track < STATS_TRACKS) {
+			// Atraso desde a criação: fila, worker e tabela de vozes
+			uint32_t latency = micros() - evt.timestampUs;
+			trackNoteCount[evt.source][evt.track]++;
+			if (latency > trackMaxLatencyUs[evt.source][evt.track]) trackMaxLatencyUs[evt.source][evt.track] = latency;
 		}
-	
-		// DINs
-		if (outs & EuclideanSequencer::OUT_DIN) {
-			MIDIRouter::sendToOutput(0, statusByte);  // DIN1
-			MIDIRouter::sendToOutput(0, evt.note);
-			MIDIRouter::sendToOutput(0, evt.velocity);
-			MIDIRouter::sendToOutput(1, statusByte);  // DIN2
-			MIDIRouter::sendToOutput(1, evt.note);
-			MIDIRouter::sendToOutput(1, evt.velocity);
-			MIDIRouter::sendToOutput(2, statusByte);  // DIN3
-			MIDIRouter::sendToOutput(2, evt.note);
-			MIDIRouter::sendToOutput(2, evt.velocity);
+		// Apenas para as portas da track que gerou a nota; cada porta passa pela
+		// sua tabela de vozes (DIN: agendador, Note Off antes de Note On)
+		for (uint8_t slot = 0; slot < VOICE_PORTS; ++slot) {
+			if (!(evt.ports & voicePortBit(slot))) continue;
+			if (slot == 3 && !usb_midi) continue;
+			if (noteOn) {
+				// Note On respeita o protocolo selecionado (Note Out)
+				uint8_t proto = (slot == 3) ? EuclideanSequencer::OUT_USB : EuclideanSequencer::OUT_DIN;
+				if (outs & proto) voiceNoteOn(slot, evt.channel, evt.note, evt.velocity);
+			} else {
+				// Note Off segue sempre o seu Note On, mesmo com o protocolo entretanto desligado
+				voiceNoteOff(slot, evt.channel, evt.note, evt.velocity);
+			}
+		}
+	}
+
+	// Protocolo desligado no Note Out: silencia o que ficou a soar nessas portas
+	uint8_t flush = voiceFlushRequest.exchange(0);
+	uint8_t removed = lastOutputNotes & ~outs;
+	lastOutputNotes = outs;
+	if (removed & EuclideanSequencer::OUT_DIN) {
+		flush |= EuclideanSequencer::PORT_DIN1 | EuclideanSequencer::PORT_DIN2 | EuclideanSequencer::PORT_DIN3;
+	}
+	if (removed & EuclideanSequencer::OUT_USB) flush |= EuclideanSequencer::PORT_USB;
+	if (flush) flushVoices(flush);
+}
+
+void EuclideanMidiEngine::sendToVoicePort(uint8_t slot, uint8_t status, uint8_t data1, uint8_t data2) {
+	MIDIRouter::sendMessageToOutput(slot < 3 ? slot : 4, status, data1, data2);
+}
+
+void EuclideanMidiEngine::voiceNoteOn(uint8_t slot, uint8_t channel, uint8_t note, uint8_t velocity) {
+	VoiceTable& v = voices[slot];
+	uint8_t& refs = v.refs[channel][note];
+	if (refs > 0) {
+		// Redisparo com a nota ainda a soar: o Note Off pendente do disparo
+		// anterior deixa de a cortar (só o último Note Off sai)
+		voiceRetriggers++;
+		if (refs < 255) refs++;
+		if (retriggerMode == RETRIGGER_MERGE) return;
+		// Note Off primeiro: o novo Note On começa uma nota limpa
+		sendToVoicePort(slot, 0x80 | channel, note, 0);
+	} else {
+		refs = 1;
+		v.active[channel][note >> 5] |= (1UL << (note & 31));
+		v.activeChannels |= (1 << channel);
+		activeVoices++;
+	}
+	sendToVoicePort(slot, 0x90 | channel, note, velocity);
+}
+
+void EuclideanMidiEngine::voiceNoteOff(uint8_t slot, uint8_t channel, uint8_t note, uint8_t velocity) {
+	VoiceTable& v = voices[slot];
+	uint8_t& refs = v.refs[channel][note];
+	// Já silenciada (stop/flush) ou ainda segura por um disparo mais recente
+	if (refs == 0 || --refs > 0) {
+		voiceSuppressedOffs++;
+		return;
+	}
+	v.active[channel][note >> 5] &= ~(1UL << (note & 31));
+	if (!(v.active[channel][0] | v.active[channel][1] | v.active[channel][2] | v.active[channel][3])) {
+		v.activeChannels &= ~(1 << channel);
+	}
+	activeVoices--;
+	sendToVoicePort(slot, 0x80 | channel, note, velocity);
+}
+
+void EuclideanMidiEngine::flushVoices(uint8_t ports) {
+	for (uint8_t slot = 0; slot < VOICE_PORTS; ++slot) {
+		if (!(ports & voicePortBit(slot))) continue;
+		VoiceTable& v = voices[slot];
+		// Percorre só os canais e palavras com notas ativas
+		while (v.activeChannels) {
+			uint8_t channel = __builtin_ctz(v.activeChannels);
+			for (uint8_t w = 0; w < 4; ++w) {
+				uint32_t bits = v.active[channel][w];
+				while (bits) {
+					uint8_t note = (w << 5) | __builtin_ctz(bits);
+					bits &= bits - 1;
+					v.refs[channel][note] = 0;
+					activeVoices--;
+					sendToVoicePort(slot, 0x80 | channel, note, 0);
+				}
+				v.active[channel][w] = 0;
+			}
+			v.activeChannels &= ~(1 << channel);
 		}
-		
-		midiQueueTail = (midiQueueTail + 1) % MIDI_QUEUE_SIZE;
 	}
 }
 
+void EuclideanMidiEngine::allNotesOff(uint8_t ports) {
+	voiceFlushRequest.fetch_or(ports);
+	wakeWorker();
+}
+
 // Worker task que consome a fila de eventos MIDI
 void EuclideanMidiEngine::midiWorkerTask(void* pvParameters) {
 	EuclideanMidiEngine* engine = reinterpret_cast<EuclideanMidiEngine*>(pvParameters);
@@ -131,116 +186,389 @@ void EuclideanMidiEngine::midiWorkerTask(void* pvParameters) {
 		return;
 	}
 	for (;;) {
-		// Aguarda até haver eventos enfileirados
-		if (engine->midiQueueSem && xSemaphoreTake(engine->midiQueueSem, pdMS_TO_TICKS(200)) == pdTRUE) {
-			// Processa enquanto houver eventos
-			engine->processMidiQueue();
-		} else {
-			// Sem evento, pequena espera para liberar CPU
-			vTaskDelay(pdMS_TO_TICKS(1));
+		engine->processNoteOffs();
+		// Processa enquanto houver eventos
+		engine->processMidiQueue();
+		// Bytes DIN que esperavam pelo orçamento das portas
+		MIDIRouter::pumpDinOutputs();
+		// Pacotes USB deste ciclo num só lote
+		MIDIRouter::flushUsbOutput();
+
+		// Anuncia que vai dormir e volta a verificar a fila: um evento publicado
+		// entre o último pop e este ponto não fica sem notificação
+		engine->workerWaiting.store(true);
+		if (!engine->midiQueue.empty() || engine->voiceFlushRequest.load()) {
+			engine->workerWaiting.store(false);
+			continue;
 		}
+		// Com Note Offs ou bytes DIN pendentes acorda a cada tick do RTOS
+		bool busy = !engine->noteOffWheel.empty() || MIDIRouter::hasPendingDinOutput();
+		TickType_t wait = busy ? 1 : pdMS_TO_TICKS(200);
+		ulTaskNotifyTake(pdTRUE, wait);
+		engine->workerWaiting.store(false);
 	}
 }
 
-void EuclideanMidiEngine::enqueueNoteEvent(uint8_t channel, uint8_t note, uint8_t velocity, uint16_t noteLength, bool isNoteOn) {
-	enqueueMidiEvent(channel, note, velocity, noteLength, isNoteOn);
+void EuclideanMidiEngine::emitNote(const NoteEvent& evt) {
+	NoteEvent e = evt;
+	e.channel &= 0x0F;
+	e.note &= 0x7F;
+	e.velocity &= 0x7F;
+	enqueueMidiEvent(e);
+	// Cada nota tem o seu próprio Note Off, mesmo que a track volte a disparar antes
+	if (e.isNoteOn && e.gateUs > 0) scheduleNoteOff(e);
+}
+
+uint32_t EuclideanMidiEngine::packNoteOff(const NoteEvent& on) {
+	// USB (bit 4 das portas) passa para o bit 3: as portas cabem em 5 bits
+	uint8_t ports = (on.ports & 0x07) | ((on.ports & EuclideanSequencer::PORT_USB) >> 1);
+	return (uint32_t)on.channel
+	     | ((uint32_t)on.note << 4)
+	     | ((uint32_t)on.velocity << 11)
+	     | ((uint32_t)(ports & 0x1F) << 18)
+	     | ((uint32_t)(on.track & 0x3F) << 23)
+	     | ((uint32_t)(on.source & 0x03) << 29);
+}
+
+void EuclideanMidiEngine::unpackNoteOff(uint32_t payload, NoteEvent& off) {
+	uint8_t ports = (payload >> 18) & 0x1F;
+	off.channel = payload & 0x0F;
+	off.note = (payload >> 4) & 0x7F;
+	off.velocity = (payload >> 11) & 0x7F;
+	off.ports = (ports & 0x07) | ((ports & 0x08) << 1);
+	off.track = (payload >> 23) & 0x3F;
+	off.source = (payload >> 29) & 0x03;
+	off.gateUs = 0;
+	off.isNoteOn = false;
+}
+
+bool EuclideanMidiEngine::scheduleNoteOff(const NoteEvent& on) {
+	uint32_t payload = packNoteOff(on);
+	portENTER_CRITICAL(&noteOffMux);
+	bool ok = noteOffWheel.schedule(micros(), on.gateUs, payload);
+	portEXIT_CRITICAL(&noteOffMux);
+	return ok;
+}
+
+void EuclideanMidiEngine::resetTrackStats() {
+	memset(trackNoteCount, 0, sizeof(trackNoteCount));
+	memset(trackMaxLatencyUs, 0, sizeof(trackMaxLatencyUs));
+}
+
+uint32_t EuclideanMidiEngine::gateLengthUs(uint8_t gateMode, uint8_t gateAmount, uint16_t lengthMs, uint16_t stepTicks, uint8_t divisions) {
+	if (!clock) return (uint32_t)lengthMs * 1000UL;
+	if (divisions == 0) divisions = 1;
+
+	// Período de tick em vigor no Note On (segue rampas de tempo e o clock externo).
+	// Com ratchet cada nota ocupa 1/divisions do step.
+	uint32_t tickUs = clock->getTickPeriodUs();
+	uint32_t stepUs = tickUs * stepTicks / divisions;
+	if (gateMode == EuclideanSequencer::GATE_MS) {
+		uint32_t gateUs = (uint32_t)lengthMs * 1000UL;
+		// Ratchet: cada nota termina antes da seguinte (sem ratchet, ms fixos como antes)
+		if (divisions > 1 && stepUs > GATE_GUARD_US + GATE_MIN_US && gateUs > stepUs - GATE_GUARD_US) gateUs = stepUs - GATE_GUARD_US;
+		return gateUs;
+	}
+	uint32_t gateUs = (gateMode == EuclideanSequencer::GATE_TICKS)
+		? tickUs * gateAmount
+		: (uint32_t)((uint64_t)stepUs * gateAmount / 100);
+	// Um gate de step inteiro (ou mais) termina pouco antes do step seguinte:
+	// o Note Off nunca chega depois do Note On que volta a tocar a mesma nota
+	if (stepUs > GATE_GUARD_US + GATE_MIN_US && gateUs > stepUs - GATE_GUARD_US) gateUs = stepUs - GATE_GUARD_US;
+	if (gateUs < GATE_MIN_US) gateUs = GATE_MIN_US;
+	return gateUs;
+}
+
+void EuclideanMidiEngine::processNoteOffs() {
+	uint32_t expired[NOTE_OFF_BATCH];
+	uint16_t n;
+	do {
+		// Recolhe em lote dentro da secção crítica; enfileira fora dela
+		portENTER_CRITICAL(&noteOffMux);
+		n = noteOffWheel.advance(micros(), expired, NOTE_OFF_BATCH);
+		portEXIT_CRITICAL(&noteOffMux);
+		for (uint16_t i = 0; i < n; ++i) {
+			NoteEvent off;
+			unpackNoteOff(expired[i], off);
+			off.timestampUs = micros();
+			enqueueMidiEvent(off);
+		}
+	} while (n == NOTE_OFF_BATCH);
 }
 
 void EuclideanMidiEngine::onSequencerNote(uint8_t status, uint8_t data1, uint8_t data2) {
-	if (!euclSeq) return;
-	
-	uint8_t channel = status & 0x0F;
 	uint8_t msgType = status & 0xF0;
+	if (msgType != 0x90 && msgType != 0x80) return;
 	
-	// Procura a primeira track com este canal MIDI para obter noteLength
-	uint16_t noteLength = 100;  // padrão
-	for (uint8_t trackIdx = 0; trackIdx < 8; trackIdx++) {
-		if (euclSeq->getTrackMidiChannel(trackIdx) == channel) {
-			noteLength = euclSeq->getTrackNoteLength(trackIdx);
-			break;
+	// Sem identidade de track: todas as portas, com o gate da primeira track
+	// ativa neste canal (ou EXTERNAL_GATE_MS). Um Note Off explícito de quem
+	// usa onSendMidi é absorvido pela tabela de vozes (só sai um).
+	uint8_t channel = status & 0x0F;
+	uint8_t track = 0;
+	uint16_t lengthMs = EXTERNAL_GATE_MS;
+	if (euclSeq) {
+		for (uint8_t t = 0; t < EuclideanSequencer::MAX_TRACKS; ++t) {
+			if (euclSeq->isTrackActive(t) && euclSeq->getTrackMidiChannel(t) == channel) {
+				track = t;
+				lengthMs = euclSeq->getTrackNoteLength(t);
+				break;
+			}
 		}
 	}
-	
-	if (msgType == 0x90) {  // Note On
-		enqueueMidiEvent(channel, data1, data2, noteLength, true);
-	} else if (msgType == 0x80) {  // Note Off
-		enqueueMidiEvent(channel, data1, data2, noteLength, false);
+	NoteEvent evt;
+	evt.timestampUs = micros();
+	evt.gateUs = (msgType == 0x90) ? (uint32_t)lengthMs * 1000UL : 0;
+	evt.channel = channel;
+	evt.note = data1;
+	evt.velocity = data2;
+	evt.ports = EuclideanSequencer::PORT_ALL;
+	evt.track = track;
+	evt.source = SOURCE_EXTERNAL;
+	evt.isNoteOn = (msgType == 0x90);
+	emitNote(evt);
+}
+
+void EuclideanMidiEngine::resetRender(uint32_t tick) {
+	renderPending = 0;
+	for (uint8_t trackIdx = 0; trackIdx < EuclideanSequencer::MAX_TRACKS; ++trackIdx) {
+		TrackRender& r = trackRender[trackIdx];
+		r.head = 0;
+		r.tail = 0;
+		r.renderedUpTo = tick;
+		r.editGen = euclSeq ? euclSeq->getTrackEditGen(trackIdx) : 0;
+		// Mesma semente e mesma track: a mesma sequência de decisões a cada Start/SPP
+		uint32_t seed = (euclSeq ? euclSeq->getRandomSeed() : 0) ^ (0x9E3779B9u * (trackIdx + 1));
+		r.rng = seed ? seed : 1;
 	}
 }
 
-void EuclideanMidiEngine::registerClockCallbacks() {
-	if (!clock) return;
-	clock->setStepStartCallback(euclidStepStartWrapper);
+void EuclideanMidiEngine::renderTrack(uint8_t trackIdx, uint32_t untilTick) {
+	TrackRender& r = trackRender[trackIdx];
+	if (r.renderedUpTo > untilTick) return;
+	uint64_t mask = euclSeq->getTrackPatternMask(trackIdx);
+	if (!(euclSeq->getPlayingTracks() & EuclideanSequencer::trackBit(trackIdx)) || mask == 0) {
+		r.renderedUpTo = untilTick + 1;
+		return;
+	}
+
+	uint16_t trackTicksPerStep = ticksPerResolution[euclSeq->getTrackResolution(trackIdx) - 1];
+	// Só as fronteiras de step dentro da janela podem ter nota
+	uint32_t tick = ((r.renderedUpTo + trackTicksPerStep - 1) / trackTicksPerStep) * trackTicksPerStep;
+	if (tick > untilTick) {
+		// Nenhum step começa nesta janela (o caso comum a cada tick)
+		r.renderedUpTo = untilTick + 1;
+		return;
+	}
+	uint8_t trackSteps = euclSeq->getTrackSteps(trackIdx);
+	if (trackSteps == 0) trackSteps = 1;
+	uint8_t note = euclSeq->getTrackNote(trackIdx);
+	uint8_t velocity = euclSeq->getTrackVelocity(trackIdx);
+	uint8_t channel = euclSeq->getTrackMidiChannel(trackIdx);
+	uint16_t lengthMs = euclSeq->getTrackNoteLength(trackIdx);
+	uint8_t ports = euclSeq->getTrackOutputPorts(trackIdx);
+	uint8_t gateMode = euclSeq->getTrackGateMode(trackIdx);
+	uint8_t gateAmount = euclSeq->getTrackGateAmount(trackIdx);
+	uint8_t probability = euclSeq->getTrackProbability(trackIdx);
+	uint64_t chanceSteps = euclSeq->getTrackChanceSteps(trackIdx);
+	uint8_t ratchet = euclSeq->getTrackRatchet(trackIdx);
+	uint64_t ratchetSteps = euclSeq->getTrackRatchetSteps(trackIdx);
+	const uint32_t stepSubticks = (uint32_t)trackTicksPerStep * MidiClock::SUBTICKS_PER_TICK;
+	if (ports == 0) {
+		// Track sem portas: nada a renderizar
+		r.renderedUpTo = untilTick + 1;
+		return;
+	}
+
+	uint8_t trackEuclStep = (tick / trackTicksPerStep) % trackSteps;
+	for (; tick <= untilTick; tick += trackTicksPerStep) {
+		uint8_t step = trackEuclStep;
+		if (++trackEuclStep >= trackSteps) trackEuclStep = 0;
+		if (!((mask >> step) & 1)) continue;
+		uint8_t count = ((ratchetSteps >> step) & 1) ? ratchet : 1;
+		if ((uint8_t)(RENDER_SLOTS - (uint8_t)(r.head - r.tail)) < count) {
+			// Buffer sem espaço para o step inteiro: o resto da janela (a partir
+			// deste step, ainda sem sorteio) é renderizado no próximo tick
+			r.renderedUpTo = tick;
+			return;
+		}
+		if (probability < EuclideanSequencer::MAX_PROBABILITY && ((chanceSteps >> step) & 1) && !chance(r.rng, probability)) continue;
+		// Ratchet: `count` notas repartidas por igual pelo step, cada uma com a
+		// sua posição 960 PPQN (as que caem entre ticks são agendadas no clock)
+		uint32_t stepPos = tick * MidiClock::SUBTICKS_PER_TICK;
+		for (uint8_t k = 0; k < count; ++k) {
+			RenderedNote& n = r.events[r.head & (RENDER_SLOTS - 1)];
+			n.position = stepPos + stepSubticks * k / count;
+			n.channel = channel;
+			n.note = note;
+			n.velocity = velocity;
+			n.lengthMs = lengthMs;
+			n.ports = ports;
+			n.gateMode = gateMode;
+			n.gateAmount = gateAmount;
+			n.stepTicks = (uint8_t)trackTicksPerStep;
+			n.ratchet = count;
+			r.head++;
+		}
+		renderPending |= EuclideanSequencer::trackBit(trackIdx);
+	}
+	r.renderedUpTo = untilTick + 1;
 }
 
-void EuclideanMidiEngine::onStepStart(uint8_t step) {
-	if (!euclSeq || !clock) return;
-	
-	// Usa contador global de TICKS PPQN do clock para calcular steps euclidiano
-	uint32_t globalTickCount = clock->getTickCount();
-	
-	// Atualiza passo visual da track selecionada
+void EuclideanMidiEngine::flushDueNotes(uint32_t position) {
+	EuclideanSequencer::TrackMask pending = renderPending;
+	while (pending) {
+		uint8_t trackIdx = EuclideanSequencer::lowestTrack(pending);
+		pending &= pending - 1;
+		TrackRender& r = trackRender[trackIdx];
+		while (r.tail != r.head) {
+			const RenderedNote& n = r.events[r.tail & (RENDER_SLOTS - 1)];
+			if ((int32_t)(n.position - position) > 0) break;
+			// Send the note stored in the sequencer as-is (internal value already adjusted),
+			// only to the ports of the track that rendered it
+			NoteEvent evt;
+			evt.timestampUs = micros();
+			// O gate é medido a partir deste Note On, ao tempo atual
+			evt.gateUs = gateLengthUs(n.gateMode, n.gateAmount, n.lengthMs, n.stepTicks, n.ratchet);
+			evt.channel = n.channel;
+			evt.note = n.note;
+			evt.velocity = n.velocity;
+			evt.ports = n.ports;
+			evt.track = trackIdx;
+			evt.source = SOURCE_EUCLIDEAN;
+			evt.isNoteOn = true;
+			emitNote(evt);
+			r.tail++;
+		}
+		if (r.tail == r.head) renderPending &= ~EuclideanSequencer::trackBit(trackIdx);
+	}
+}
+
+void EuclideanMidiEngine::scheduleSubtickNotes(uint32_t fromPos, uint32_t toPos) {
+	// O timer do clock arma o próximo evento em cada fronteira de tick: uma
+	// posição entre ticks tem de estar agendada antes do tick que a precede.
+	// Tracks com a mesma grelha partilham posições: cada uma é pedida uma vez.
+	uint32_t asked[16];
+	uint8_t askedCount = 0;
+	EuclideanSequencer::TrackMask pending = renderPending;
+	while (pending) {
+		uint8_t trackIdx = EuclideanSequencer::lowestTrack(pending);
+		pending &= pending - 1;
+		const TrackRender& r = trackRender[trackIdx];
+		for (uint8_t i = r.tail; i != r.head; ++i) {
+			uint32_t pos = r.events[i & (RENDER_SLOTS - 1)].position;
+			if ((int32_t)(pos - toPos) >= 0) break;
+			if ((int32_t)(pos - fromPos) <= 0 || pos % MidiClock::SUBTICKS_PER_TICK == 0) continue;
+			bool seen = false;
+			for (uint8_t a = 0; a < askedCount && !seen; ++a) seen = (asked[a] == pos);
+			if (seen) continue;
+			if (askedCount < sizeof(asked) / sizeof(asked[0])) asked[askedCount++] = pos;
+			// Agenda cheia: a nota sai no tick seguinte (flushDueNotes)
+			clock->scheduleAt(pos);
+		}
+	}
+}
+
+void EuclideanMidiEngine::updateVisualSteps(uint32_t tick) {
+	// Passo visual da track selecionada
 	uint8_t selectedPattern = euclSeq->getSelectedPattern();
-	uint8_t selectedResolution = euclSeq->getTrackResolution(selectedPattern);
-	uint8_t selectedSteps = euclSeq->getSteps();
-	
-	// Calcula o step euclidiano para a track selecionada
-	// ticksPerResolution[res-1] = número de TICKS PPQN para um step euclidiano
-	uint16_t ticksPerEuclStep = ticksPerResolution[selectedResolution - 1];
-	uint8_t selectedEuclStep = (globalTickCount / ticksPerEuclStep) % selectedSteps;
-	euclSeq->setCurrentStep(selectedEuclStep);
-	
-	// Polyphony: verifica todas as tracks ativas e habilitadas
-	for (uint8_t trackIdx = 0; trackIdx < 8; ++trackIdx) {
-		if (!(euclSeq->isTrackActive(trackIdx) && euclSeq->isTrackEnabled(trackIdx))) continue;
+	uint16_t ticksPerEuclStep = ticksPerResolution[euclSeq->getTrackResolution(selectedPattern) - 1];
+	euclSeq->setCurrentStep((tick / ticksPerEuclStep) % euclSeq->getSteps());
 
-		uint8_t trackResolution = euclSeq->getTrackResolution(trackIdx);
-		uint16_t trackTicksPerStep = ticksPerResolution[trackResolution - 1];
-		uint8_t trackSteps = euclSeq->getTrackSteps(trackIdx);
+	EuclideanSequencer::TrackMask playing = euclSeq->getPlayingTracks();
+	while (playing) {
+		uint8_t trackIdx = EuclideanSequencer::lowestTrack(playing);
+		playing &= playing - 1;
+		uint16_t trackTicksPerStep = ticksPerResolution[euclSeq->getTrackResolution(trackIdx) - 1];
+		euclSeq->setTrackCurrentStep(trackIdx, (tick / trackTicksPerStep) % euclSeq->getTrackSteps(trackIdx));
+	}
+}
 
-		// Calcula o step euclidiano ATUAL para esta track
-		uint8_t trackEuclStep = (globalTickCount / trackTicksPerStep) % trackSteps;
-		euclSeq->setTrackCurrentStep(trackIdx, trackEuclStep);
+uint32_t EuclideanMidiEngine::lookaheadTicks() const {
+	// Janela de render em ticks ao tempo atual (acompanha rampas e SLAVE)
+	uint32_t tickUs = clock->getTickPeriodUs();
+	uint32_t aheadTicks = tickUs ? (LOOKAHEAD_US + tickUs - 1) / tickUs : 1;
+	if (aheadTicks < 1) aheadTicks = 1;
+	if (aheadTicks > MAX_LOOKAHEAD_TICKS) aheadTicks = MAX_LOOKAHEAD_TICKS;
+	return aheadTicks;
+}
 
-		// Compara com o ÚLTIMO STEP PROCESSADO (não com o anterior)
-		if (trackEuclStep == lastProcessedStep[trackIdx]) continue;
-		lastProcessedStep[trackIdx] = trackEuclStep;
-
-		// Verifica padrão euclidiano
-		if (!euclSeq->getTrackPatternBit(trackIdx, trackEuclStep)) continue;
-
-		// Send the note stored in the sequencer as-is (internal value already adjusted)
-		uint8_t note = euclSeq->getTrackNote(trackIdx);
-		uint8_t velocity = euclSeq->getTrackVelocity(trackIdx);
-		uint8_t channel = euclSeq->getTrackMidiChannel(trackIdx);
-		uint8_t status = 0x90 | channel;
-		euclSeq->onSendMidi(status, note, velocity);
-
-		// Agenda note-off para esta track (usando duração configurada)
-		pendingNoteOffs[trackIdx].pending = true;
-		pendingNoteOffs[trackIdx].note = note;
-		pendingNoteOffs[trackIdx].channel = channel & 0x0F;  // Garante apenas 4 bits para canal
-		pendingNoteOffs[trackIdx].velocity = velocity;  // Armazena velocity original
-		uint16_t noteLength = euclSeq->getTrackNoteLength(trackIdx);  // Obtém duração configurada
-		pendingNoteOffs[trackIdx].noteLength = noteLength;  // Armazena para usar no NOTE OFF
-		pendingNoteOffs[trackIdx].time = (uint32_t)millis() + noteLength;
-	}
-}
-
-void EuclideanMidiEngine::update() {
-	// Processa todos os Note Offs pendentes
-	uint32_t now = millis();
-	for (uint8_t t = 0; t < 8; ++t) {
-		if (pendingNoteOffs[t].pending && now >= pendingNoteOffs[t].time) {
-			pendingNoteOffs[t].pending = false;
-			// Enfileira NOTE OFF com noteLength armazenado
-			enqueueMidiEvent(pendingNoteOffs[t].channel, pendingNoteOffs[t].note, 
-							 pendingNoteOffs[t].velocity, pendingNoteOffs[t].noteLength, false);
+void EuclideanMidiEngine::onClockTick() {
+	if (!euclSeq || !clock) return;
+	uint32_t tick = clock->getTickCount();
+
+	// Saída primeiro: notas já calculadas, emitidas no instante do tick
+	flushDueNotes(tick * MidiClock::SUBTICKS_PER_TICK);
+	updateVisualSteps(tick);
+
+	uint32_t aheadTicks = lookaheadTicks();
+
+	// Só as tracks que tocam ou ainda têm notas por emitir: o custo por tick
+	// segue o número de tracks em uso, não MAX_TRACKS. Ligar/desligar uma track
+	// muda a sua geração de edição, por isso uma track que volta a tocar é
+	// sempre renderizada de novo a partir do próximo tick.
+	EuclideanSequencer::TrackMask tracks = euclSeq->getPlayingTracks() | renderPending;
+	while (tracks) {
+		uint8_t trackIdx = EuclideanSequencer::lowestTrack(tracks);
+		tracks &= tracks - 1;
+		TrackRender& r = trackRender[trackIdx];
+		uint8_t gen = euclSeq->getTrackEditGen(trackIdx);
+		if (gen != r.editGen) {
+			// Track editada: descarta só o que ela ainda não emitiu e volta a
+			// renderizar a partir do próximo tick; as outras tracks ficam intactas
+			r.editGen = gen;
+			r.head = r.tail;
+			r.renderedUpTo = tick + 1;
+			renderPending &= ~EuclideanSequencer::trackBit(trackIdx);
 		}
+		renderTrack(trackIdx, tick + aheadTicks);
+	}
+	// Ratchets entre o próximo tick e o seguinte
+	if (renderPending) scheduleSubtickNotes((tick + 1) * MidiClock::SUBTICKS_PER_TICK, (tick + 2) * MidiClock::SUBTICKS_PER_TICK);
+}
+
+void EuclideanMidiEngine::onTransportStart() {
+	if (!euclSeq || !clock) return;
+	// O tick 0 não tem evento de tick próprio: o seu step sai com o Start
+	resetRender(0);
+	EuclideanSequencer::TrackMask playing = euclSeq->getPlayingTracks();
+	while (playing) {
+		uint8_t trackIdx = EuclideanSequencer::lowestTrack(playing);
+		playing &= playing - 1;
+		renderTrack(trackIdx, 0);
+	}
+	flushDueNotes(0);
+	updateVisualSteps(0);
+	// O timer já está armado para o tick 1: ratchets antes dele saem com o tick
+	if (renderPending) scheduleSubtickNotes(0, 2 * MidiClock::SUBTICKS_PER_TICK);
+}
+
+void EuclideanMidiEngine::relocate(uint32_t tick) {
+	if (!euclSeq || !clock) return;
+	
+	for (uint8_t trackIdx = 0; trackIdx < EuclideanSequencer::MAX_TRACKS; ++trackIdx) {
+		uint16_t trackTicksPerStep = ticksPerResolution[euclSeq->getTrackResolution(trackIdx) - 1];
+		uint8_t trackSteps = euclSeq->getTrackSteps(trackIdx);
+		uint8_t trackEuclStep = (tick / trackTicksPerStep) % trackSteps;
+		euclSeq->setTrackCurrentStep(trackIdx, trackEuclStep);
 	}
 	
-		// Processa fila unificada de MIDI (USB)
-		// Nota: a fila MIDI agora é processada pela task `MIDIWorker` para evitar bloqueios.
+	// Posição no início de um step: o step toca no próximo tick.
+	// A meio de um step: só a fronteira seguinte tem nota a renderizar.
+	// Renderiza já a janela inteira, como no Start: o próximo tick começa pela
+	// saída e só encontra as notas que já estiverem no buffer.
+	resetRender(tick);
+	EuclideanSequencer::TrackMask playing = euclSeq->getPlayingTracks();
+	uint32_t aheadTicks = lookaheadTicks();
+	while (playing) {
+		uint8_t trackIdx = EuclideanSequencer::lowestTrack(playing);
+		playing &= playing - 1;
+		renderTrack(trackIdx, tick + aheadTicks);
+	}
+	// A agenda do clock foi limpa pelo SPP: ratchets até ao tick seguinte ao próximo
+	if (renderPending) scheduleSubtickNotes(tick * MidiClock::SUBTICKS_PER_TICK, (tick + 2) * MidiClock::SUBTICKS_PER_TICK);
+	
+	uint8_t selectedPattern = euclSeq->getSelectedPattern();
+	euclSeq->setCurrentStep(euclSeq->getTrackCurrentStep(selectedPattern));
 }
 
 bool EuclideanMidiEngine::isOSCClientConnected() const {
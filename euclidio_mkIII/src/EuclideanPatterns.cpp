@@ -0,0 +1,101 @@
+#include "EuclideanPatterns.h"
+
+namespace {
+
+// Ancorado no passo 0: hit em i quando ((i * hits) % steps) < hits
+constexpr uint64_t generateAnchored(uint8_t steps, uint8_t hits) {
+  uint64_t mask = 0;
+  for (uint8_t i = 0; i < steps; ++i) {
+    if ((((uint16_t)i * hits) % steps) < hits) mask |= (1ULL << i);
+  }
+  return mask;
+}
+
+// Bresenham: hit no step em que a reta i*hits/steps muda de inteiro
+constexpr uint64_t generateBresenham(uint8_t steps, uint8_t hits) {
+  uint64_t mask = 0;
+  for (uint8_t i = 0; i < steps; ++i) {
+    if ((((uint16_t)(i + 1) * hits) % steps) < hits) mask |= (1ULL << i);
+  }
+  return mask;
+}
+
+// Bjorklund: começa com `hits` grupos "1" (A) e `steps - hits` grupos "0" (B)
+// e junta um B ao fim de cada A enquanto sobrar mais de um grupo de resto,
+// como no algoritmo de Euclides. Os grupos são máscaras com o seu comprimento.
+constexpr uint64_t generateBjorklund(uint8_t steps, uint8_t hits) {
+  uint64_t a = 1, b = 0;
+  uint8_t lenA = 1, lenB = 1;
+  uint8_t countA = hits, countB = (uint8_t)(steps - hits);
+  while (countB > 1) {
+    uint8_t pairs = (countA < countB) ? countA : countB;
+    uint64_t joined = a | (b << lenA);
+    uint8_t joinedLen = (uint8_t)(lenA + lenB);
+    if (countA > countB) {
+      // Sobram grupos A: passam a ser o resto
+      b = a;
+      lenB = lenA;
+      countB = (uint8_t)(countA - pairs);
+    } else {
+      countB = (uint8_t)(countB - pairs);
+    }
+    a = joined;
+    lenA = joinedLen;
+    countA = pairs;
+  }
+  uint64_t mask = 0;
+  uint8_t pos = 0;
+  for (uint8_t i = 0; i < countA; ++i, pos += lenA) mask |= a << pos;
+  for (uint8_t i = 0; i < countB; ++i, pos += lenB) mask |= b << pos;
+  return mask;
+}
+
+constexpr uint64_t generate(uint8_t algo, uint8_t steps, uint8_t hits) {
+  if (steps == 0 || hits == 0) return 0;
+  if (hits >= steps) return EuclideanPatterns::lowMask(steps);
+  return (algo == EuclideanPatterns::ALGO_BJORKLUND) ? generateBjorklund(steps, hits)
+       : (algo == EuclideanPatterns::ALGO_BRESENHAM) ? generateBresenham(steps, hits)
+       : generateAnchored(steps, hits);
+}
+
+struct PatternTable {
+  uint64_t masks[EuclideanPatterns::ALGO_COUNT][EuclideanPatterns::TABLE_SIZE];
+
+  constexpr PatternTable() : masks() {
+    for (uint8_t algo = 0; algo < EuclideanPatterns::ALGO_COUNT; ++algo) {
+      for (uint8_t s = 1; s <= EuclideanPatterns::MAX_STEPS; ++s) {
+        for (uint8_t h = 0; h <= s; ++h) {
+          masks[algo][EuclideanPatterns::rowStart(s) + h] = generate(algo, s, h);
+        }
+      }
+    }
+  }
+
+  constexpr uint64_t at(uint8_t algo, uint8_t steps, uint8_t hits) const {
+    return masks[algo][EuclideanPatterns::rowStart(steps) + hits];
+  }
+};
+
+// const em âmbito de ficheiro: vai para .rodata (flash), não para a RAM
+constexpr PatternTable TABLE;
+
+static_assert(EuclideanPatterns::rowStart(EuclideanPatterns::MAX_STEPS + 1) == EuclideanPatterns::TABLE_SIZE,
+              "EuclideanPatterns: tamanho da tabela");
+static_assert(TABLE.at(EuclideanPatterns::ALGO_ANCHORED, 8, 3) == 0x49, "E(3,8) = x..x..x.");
+static_assert(TABLE.at(EuclideanPatterns::ALGO_ANCHORED, 16, 4) == 0x1111, "E(4,16) = four on the floor");
+static_assert(TABLE.at(EuclideanPatterns::ALGO_ANCHORED, 64, 64) == ~0ULL, "E(64,64) = todos os steps");
+// Bjorklund: exemplos de Toussaint, "The Euclidean algorithm generates traditional musical rhythms"
+static_assert(TABLE.at(EuclideanPatterns::ALGO_BJORKLUND, 8, 5) == 0x6D, "E(5,8) = x.xx.xx.");
+static_assert(TABLE.at(EuclideanPatterns::ALGO_BJORKLUND, 12, 7) == 0x5AD, "E(7,12) = x.xx.x.xx.x.");
+static_assert(TABLE.at(EuclideanPatterns::ALGO_BJORKLUND, 16, 9) == 0x56AD, "E(9,16) = x.xx.x.x.xx.x.x.");
+static_assert(TABLE.at(EuclideanPatterns::ALGO_BRESENHAM, 8, 3) == 0xA4, "Bresenham E(3,8) = ..x..x.x");
+
+}  // namespace
+
+uint64_t EuclideanPatterns::base(uint8_t steps, uint8_t hits, Algorithm algo) {
+  if (steps == 0) return 0;
+  if (steps > MAX_STEPS) steps = MAX_STEPS;
+  if (hits > steps) hits = steps;
+  if (algo >= ALGO_COUNT) algo = ALGO_ANCHORED;
+  return TABLE.at(algo, steps, hits);
+}
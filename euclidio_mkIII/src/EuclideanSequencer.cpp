@@ -1,12 +1,20 @@
 #include "EuclideanSequencer.h"
 #include "Encoder.h"
+#include "EuclideanPatterns.h"
 
 EuclideanSequencer::EuclideanSequencer()
   : currentStep(0), selectedPattern(0), isRunning(false), 
     lastStepTime(0), currentEditParam(PARAM_PLAY), 
     outputNotes(OUT_ALL), outputClock(OUT_ALL), outputMidiMap(true), outputOSCMap(true) {
-  pattern.reserve(MAX_STEPS);
-  for (uint8_t i = 0; i < 8; ++i) trackCurrentStep[i] = 0;
+  pattern = 0;
+  playingTracks = 0;
+  for (uint8_t i = 0; i < MAX_TRACKS; ++i) {
+    trackCurrentStep[i] = 0;
+    trackEditGen[i] = 0;
+    trackMask[i] = 0;
+    trackStepCount[i] = DEFAULT_STEPS;
+    trackResolution[i] = 1;
+  }
 }
 
 void EuclideanSequencer::begin() {
@@ -22,11 +30,27 @@ void EuclideanSequencer::begin() {
   currentConfig.playMode = STOP;        // Modo de play padrão (parado)
   currentConfig.active = true;
   currentConfig.enabled = false;         // Dub OFF por padrão
+  currentConfig.outputPorts = PORT_ALL;  // todas as portas (DIN1-3 e USB)
+  currentConfig.gateMode = GATE_MS;      // gate em ms (noteLength)
+  currentConfig.gateAmount = DEFAULT_GATE_AMOUNT;
+  currentConfig.algorithm = EuclideanPatterns::ALGO_ANCHORED;
+  currentConfig.probability = MAX_PROBABILITY;
+  currentConfig.ratchet = 1;
+  currentConfig.chanceSteps = ALL_STEPS;
+  currentConfig.ratchetSteps = ALL_STEPS;
   
   // Inicializa padrões salvos: slot 0 ativo com config atual
   for (uint8_t i = 0; i < MAX_PATTERNS; i++) {
     patterns[i].active = false;
     patterns[i].enabled = false; // Dub OFF por padrão em todas as tracks
+    patterns[i].outputPorts = PORT_ALL;
+    patterns[i].gateMode = GATE_MS;
+    patterns[i].gateAmount = DEFAULT_GATE_AMOUNT;
+    patterns[i].algorithm = EuclideanPatterns::ALGO_ANCHORED;
+    patterns[i].probability = MAX_PROBABILITY;
+    patterns[i].ratchet = 1;
+    patterns[i].chanceSteps = ALL_STEPS;
+    patterns[i].ratchetSteps = ALL_STEPS;
   }
   patterns[0] = currentConfig;
   patterns[0].active = true;
@@ -36,58 +60,41 @@ void EuclideanSequencer::begin() {
 }
 
 void EuclideanSequencer::generatePattern() {
-  pattern.clear();
-  bjorklundAlgorithm(currentConfig.steps, currentConfig.hits);
+  pattern = EuclideanPatterns::get(currentConfig.steps, currentConfig.hits, currentConfig.offset,
+                                   (EuclideanPatterns::Algorithm)currentConfig.algorithm);
   // Persistir no slot atual
   if (selectedPattern < MAX_PATTERNS) {
+    uint64_t oldMask = trackMask[selectedPattern];
+    uint8_t oldSteps = trackStepCount[selectedPattern];
+    uint8_t oldResolution = trackResolution[selectedPattern];
+    bool wasPlaying = (playingTracks & trackBit(selectedPattern)) != 0;
     patterns[selectedPattern] = currentConfig;
     patterns[selectedPattern].active = true;
+    rebuildTrackMask(selectedPattern);
+    // Só um padrão diferente invalida o render antecipado: navegar entre tracks
+    // ou regenerar o mesmo padrão mantém a geração (e os sorteios já feitos)
+    if (trackMask[selectedPattern] != oldMask || trackStepCount[selectedPattern] != oldSteps ||
+        trackResolution[selectedPattern] != oldResolution ||
+        ((playingTracks & trackBit(selectedPattern)) != 0) != wasPlaying) {
+      trackEditGen[selectedPattern]++;
+    }
   }
 }
 
-void EuclideanSequencer::bjorklundAlgorithm(uint8_t steps, uint8_t hits) {
-  // Garantir que hits não excedem steps na geração
-  if (hits > steps) hits = steps;
-  if (steps == 0 || hits == 0) {
-    for (uint8_t i = 0; i < steps; i++) {
-      pattern.push_back(false);
-    }
-    return;
-  }
-  
-  if (hits == steps) {
-    for (uint8_t i = 0; i < steps; i++) {
-      pattern.push_back(true);
-    }
-    return;
-  }
-  
-  // Geração com ancoragem no passo 0:
-  // Hit em i quando ((i * hits) % steps) < hits
-  for (uint8_t i = 0; i < steps; i++) {
-    bool isHit = (((uint16_t)i * hits) % steps) < hits;
-    pattern.push_back(isHit);
-  }
-  
-  // Garante o tamanho correto
-  while (pattern.size() < steps) {
-    pattern.push_back(false);
-  }
-  while (pattern.size() > steps) {
-    pattern.pop_back();
-  }
-
-  // Aplica offset como rotação do padrão
-  if (steps > 0 && currentConfig.offset % steps != 0) {
-    std::vector<bool> rotated;
-    rotated.reserve(steps);
-    uint8_t off = currentConfig.offset % steps;
-    for (uint8_t i = 0; i < steps; ++i) {
-      uint8_t src = (i + steps - (off % steps)) % steps; // rotação para a direita por 'offset'
-      rotated.push_back(pattern[src]);
-    }
-    pattern.swap(rotated);
-  }
+void EuclideanSequencer::touchTrack(uint8_t trackIdx) {
+  if (trackIdx >= MAX_PATTERNS) return;
+  // Máscara primeiro: quem vê a nova geração já lê o padrão novo
+  rebuildTrackMask(trackIdx);
+  trackEditGen[trackIdx]++;
+}
+
+void EuclideanSequencer::rebuildTrackMask(uint8_t trackIdx) {
+  const EuclideanPattern& p = patterns[trackIdx];
+  trackMask[trackIdx] = p.active ? EuclideanPatterns::get(p.steps, p.hits, p.offset, (EuclideanPatterns::Algorithm)p.algorithm) : 0;
+  trackStepCount[trackIdx] = p.active ? p.steps : DEFAULT_STEPS;
+  trackResolution[trackIdx] = p.active ? p.resolution : 1;
+  if (p.active && p.enabled) playingTracks |= trackBit(trackIdx);
+  else playingTracks &= ~trackBit(trackIdx);
 }
 
 void EuclideanSequencer::start() {
@@ -108,21 +115,18 @@ void EuclideanSequencer::reset() {
 }
 
 void EuclideanSequencer::setSteps(uint8_t steps) {
-  if (steps > 0 && steps <= MAX_STEPS) {
-    currentConfig.steps = steps;
-    if (selectedPattern < MAX_PATTERNS) {
-      patterns[selectedPattern] = currentConfig;
-      patterns[selectedPattern].active = true;
-    }
-    generatePattern();
+  // Limites comuns a todas as entradas (1..MAX_STEPS)
+  currentConfig.steps = EuclideanPatterns::clampSteps(steps);
+  if (selectedPattern < MAX_PATTERNS) {
+    patterns[selectedPattern] = currentConfig;
+    patterns[selectedPattern].active = true;
   }
+  generatePattern();
 }
 
 void EuclideanSequencer::setHits(uint8_t hits) {
   // Limitar entre 1 e MAX_HITS (agora permitindo pares também)
-  if (hits == 0) hits = 1;
-  if (hits > MAX_HITS) hits = MAX_HITS;
-  currentConfig.hits = hits;
+  currentConfig.hits = EuclideanPatterns::clampHits(hits);
   if (selectedPattern < MAX_PATTERNS) {
     patterns[selectedPattern] = currentConfig;
     patterns[selectedPattern].active = true;
@@ -144,6 +148,7 @@ void EuclideanSequencer::setNote(uint8_t note) {
   if (selectedPattern < MAX_PATTERNS) {
     patterns[selectedPattern] = currentConfig;
     patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
   }
 }
 
@@ -152,6 +157,7 @@ void EuclideanSequencer::setVelocity(uint8_t vel) {
   if (selectedPattern < MAX_PATTERNS) {
     patterns[selectedPattern] = currentConfig;
     patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
   }
 }
 
@@ -161,6 +167,7 @@ void EuclideanSequencer::setMidiChannel(uint8_t channel) {
     if (selectedPattern < MAX_PATTERNS) {
       patterns[selectedPattern] = currentConfig;
       patterns[selectedPattern].active = true;
+      touchTrack(selectedPattern);
     }
   }
 }
@@ -172,6 +179,7 @@ void EuclideanSequencer::setResolution(uint8_t res) {
     if (selectedPattern < MAX_PATTERNS) {
       patterns[selectedPattern] = currentConfig;
       patterns[selectedPattern].active = true;
+      touchTrack(selectedPattern);
     }
     // Notifica mudança de resolution para atualizar cache de durações de nota
     if (onTrackChanged) onTrackChanged();
@@ -185,21 +193,91 @@ void EuclideanSequencer::setNoteLength(uint16_t length) {
     if (selectedPattern < MAX_PATTERNS) {
       patterns[selectedPattern] = currentConfig;
       patterns[selectedPattern].active = true;
+      touchTrack(selectedPattern);
     }
   }
 }
 
-bool EuclideanSequencer::getPatternBit(uint8_t step) const {
-  if (step < pattern.size()) {
-    return pattern[step];
+void EuclideanSequencer::setGateMode(GateMode mode) {
+  if (mode < GATE_MODE_COUNT) {
+    currentConfig.gateMode = mode;
+    // Mantém a quantidade dentro do intervalo do novo modo
+    setGateAmount(currentConfig.gateAmount);
   }
-  return false;
+}
+
+void EuclideanSequencer::setGateAmount(uint8_t amount) {
+  uint8_t maxAmount = (currentConfig.gateMode == GATE_PERCENT) ? 100 : MAX_GATE_TICKS;
+  currentConfig.gateAmount = constrain(amount, 1, maxAmount);
+  if (selectedPattern < MAX_PATTERNS) {
+    patterns[selectedPattern] = currentConfig;
+    patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
+  }
+}
+
+void EuclideanSequencer::setAlgorithm(EuclideanPatterns::Algorithm algo) {
+  currentConfig.algorithm = EuclideanPatterns::clampAlgorithm(algo);
+  generatePattern();
+}
+
+void EuclideanSequencer::setProbability(uint8_t percent) {
+  currentConfig.probability = percent > MAX_PROBABILITY ? (uint8_t)MAX_PROBABILITY : percent;
+  if (selectedPattern < MAX_PATTERNS) {
+    patterns[selectedPattern] = currentConfig;
+    patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
+  }
+}
+
+void EuclideanSequencer::setRatchet(uint8_t count) {
+  currentConfig.ratchet = constrain(count, 1, (int)MAX_RATCHET);
+  if (selectedPattern < MAX_PATTERNS) {
+    patterns[selectedPattern] = currentConfig;
+    patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
+  }
+}
+
+void EuclideanSequencer::setStepChance(uint8_t step, bool on) {
+  if (step >= MAX_STEPS) return;
+  uint64_t bit = 1ULL << step;
+  setChanceSteps(on ? (currentConfig.chanceSteps | bit) : (currentConfig.chanceSteps & ~bit));
+}
+
+void EuclideanSequencer::setStepRatchet(uint8_t step, bool on) {
+  if (step >= MAX_STEPS) return;
+  uint64_t bit = 1ULL << step;
+  setRatchetSteps(on ? (currentConfig.ratchetSteps | bit) : (currentConfig.ratchetSteps & ~bit));
+}
+
+void EuclideanSequencer::setChanceSteps(uint64_t mask) {
+  currentConfig.chanceSteps = mask;
+  if (selectedPattern < MAX_PATTERNS) {
+    patterns[selectedPattern] = currentConfig;
+    patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
+  }
+}
+
+void EuclideanSequencer::setRatchetSteps(uint64_t mask) {
+  currentConfig.ratchetSteps = mask;
+  if (selectedPattern < MAX_PATTERNS) {
+    patterns[selectedPattern] = currentConfig;
+    patterns[selectedPattern].active = true;
+    touchTrack(selectedPattern);
+  }
+}
+
+bool EuclideanSequencer::getPatternBit(uint8_t step) const {
+  return step < currentConfig.steps && ((pattern >> step) & 1);
 }
 
 void EuclideanSequencer::savePattern(uint8_t slot) {
   if (slot < MAX_PATTERNS) {
     patterns[slot] = currentConfig;
     patterns[slot].active = true;
+    touchTrack(slot);
   }
 }
 
@@ -207,18 +285,21 @@ void EuclideanSequencer::loadPattern(uint8_t slot) {
   if (slot < MAX_PATTERNS && patterns[slot].active) {
     currentConfig = patterns[slot];
     generatePattern();
+    // Nota, gate, etc. também mudam com o slot carregado
+    touchTrack(selectedPattern);
   }
 }
 
 void EuclideanSequencer::clearPattern(uint8_t slot) {
   if (slot < MAX_PATTERNS) {
     patterns[slot].active = false;
+    touchTrack(slot);
   }
 }
 
 // Track helpers
 void EuclideanSequencer::setSelectedPattern(uint8_t idx) {
-  selectedPattern = idx % 8;
+  selectedPattern = idx % MAX_TRACKS;
   if (selectedPattern < MAX_PATTERNS) {
     // Carregar padrão salvo ou criar novo se não existir
     if (patterns[selectedPattern].active) {
@@ -236,6 +317,14 @@ void EuclideanSequencer::setSelectedPattern(uint8_t idx) {
       currentConfig.noteLength = 100;  // Duração padrão: 100ms
       currentConfig.playMode = PLAY;
       currentConfig.active = true;
+      currentConfig.outputPorts = PORT_ALL;
+      currentConfig.gateMode = GATE_MS;
+      currentConfig.gateAmount = DEFAULT_GATE_AMOUNT;
+      currentConfig.algorithm = EuclideanPatterns::ALGO_ANCHORED;
+      currentConfig.probability = MAX_PROBABILITY;
+      currentConfig.ratchet = 1;
+      currentConfig.chanceSteps = ALL_STEPS;
+      currentConfig.ratchetSteps = ALL_STEPS;
       
       // Guardar no slot da track
       patterns[selectedPattern] = currentConfig;
@@ -318,7 +407,7 @@ void EuclideanSequencer::incrementParam(int8_t amount) {
       }
       break;
     case PARAM_TRACK:
-      setSelectedPattern(constrain((int)selectedPattern + amount, 0, 7));
+      setSelectedPattern(constrain((int)selectedPattern + amount, 0, MAX_TRACKS - 1));
       break;
     case PARAM_MIDI_CHANNEL:
       setMidiChannel(constrain(currentConfig.midiChannel + amount, 0, 15));
@@ -405,25 +494,60 @@ uint8_t EuclideanSequencer::getTrackMidiChannel(uint8_t trackIdx) const {
   return 0;
 }
 
-uint8_t EuclideanSequencer::getTrackResolution(uint8_t trackIdx) const {
+uint16_t EuclideanSequencer::getTrackNoteLength(uint8_t trackIdx) const {
+  if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
+    return patterns[trackIdx].noteLength;
+  }
+  return 100;  // default 100ms
+}
+
+EuclideanSequencer::GateMode EuclideanSequencer::getTrackGateMode(uint8_t trackIdx) const {
+  if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
+    return (GateMode)patterns[trackIdx].gateMode;
+  }
+  return GATE_MS;
+}
+
+uint8_t EuclideanSequencer::getTrackGateAmount(uint8_t trackIdx) const {
+  if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
+    return patterns[trackIdx].gateAmount;
+  }
+  return DEFAULT_GATE_AMOUNT;
+}
+
+EuclideanPatterns::Algorithm EuclideanSequencer::getTrackAlgorithm(uint8_t trackIdx) const {
+  if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
+    return (EuclideanPatterns::Algorithm)patterns[trackIdx].algorithm;
+  }
+  return EuclideanPatterns::ALGO_ANCHORED;
+}
+
+uint8_t EuclideanSequencer::getTrackProbability(uint8_t trackIdx) const {
   if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
-    return patterns[trackIdx].resolution;
+    return patterns[trackIdx].probability;
+  }
+  return MAX_PROBABILITY;
+}
+
+uint8_t EuclideanSequencer::getTrackRatchet(uint8_t trackIdx) const {
+  if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
+    return patterns[trackIdx].ratchet;
   }
   return 1;
 }
 
-uint8_t EuclideanSequencer::getTrackSteps(uint8_t trackIdx) const {
+uint64_t EuclideanSequencer::getTrackChanceSteps(uint8_t trackIdx) const {
   if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
-    return patterns[trackIdx].steps;
+    return patterns[trackIdx].chanceSteps;
   }
-  return DEFAULT_STEPS;
+  return ALL_STEPS;
 }
 
-uint16_t EuclideanSequencer::getTrackNoteLength(uint8_t trackIdx) const {
+uint64_t EuclideanSequencer::getTrackRatchetSteps(uint8_t trackIdx) const {
   if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
-    return patterns[trackIdx].noteLength;
+    return patterns[trackIdx].ratchetSteps;
   }
-  return 100;  // default 100ms
+  return ALL_STEPS;
 }
 
 uint8_t EuclideanSequencer::getTrackHits(uint8_t trackIdx) const {
@@ -440,32 +564,6 @@ uint8_t EuclideanSequencer::getTrackOffset(uint8_t trackIdx) const {
   return 0;
 }
 
-bool EuclideanSequencer::getTrackPatternBit(uint8_t trackIdx, uint8_t step) const {
-  if (trackIdx < MAX_PATTERNS && patterns[trackIdx].active) {
-    // Regenerar o padrão para esse track e verificar o bit
-    // Para simplificar, assumimos que o padrão foi calculado ao salvar
-    // Aqui apenas retornamos se o bit estaria ligado
-    if (step < patterns[trackIdx].steps) {
-      // Usa a mesma lógica de Bjorklund
-      uint8_t steps = patterns[trackIdx].steps;
-      uint8_t hits = patterns[trackIdx].hits;
-      if (hits > steps) hits = steps;
-      
-      // Aplicar offset como rotação à direita e avaliar regra do módulo
-      if (steps == 0 || hits == 0) return false;
-      if (hits == steps) return true;
-
-      uint8_t src = step;
-      if (patterns[trackIdx].offset % steps != 0) {
-        uint8_t off = patterns[trackIdx].offset % steps;
-        src = (step + steps - off) % steps;
-      }
-      return ((((uint16_t)src * hits) % steps) < hits);
-    }
-  }
-  return false;
-}
-
 // NOTE: placeholder edit-mode functions removed — edit-mode handled in main application logic
 
 void EuclideanSequencer::receiveMidiClock(uint8_t inIndex) {
@@ -490,9 +588,27 @@ bool EuclideanSequencer::isTrackEnabled(uint8_t trackIdx) const {
 void EuclideanSequencer::setTrackEnabled(uint8_t trackIdx, bool enabled) {
   if (trackIdx < MAX_PATTERNS) {
     patterns[trackIdx].enabled = enabled;
+    touchTrack(trackIdx);
     if (trackIdx == selectedPattern) {
       currentConfig.enabled = enabled;
     }
     if (onTrackChanged) onTrackChanged();
   }
 }
+
+uint8_t EuclideanSequencer::getTrackOutputPorts(uint8_t trackIdx) const {
+  if (trackIdx < MAX_PATTERNS) {
+    return patterns[trackIdx].outputPorts;
+  }
+  return PORT_ALL;
+}
+
+void EuclideanSequencer::setTrackOutputPorts(uint8_t trackIdx, uint8_t ports) {
+  if (trackIdx < MAX_PATTERNS) {
+    patterns[trackIdx].outputPorts = ports & PORT_ALL;
+    touchTrack(trackIdx);
+    if (trackIdx == selectedPattern) {
+      currentConfig.outputPorts = ports & PORT_ALL;
+    }
+  }
+}
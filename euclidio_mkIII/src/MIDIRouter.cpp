@@ -8,6 +8,7 @@
 // BLE support removed
 
 #include "EuclideanHarmonicSequencer.h"
+#include "EuclideanMidiEngine.h"
 #include <Adafruit_TinyUSB.h>
 
 // Ponteiros para matriz de roteamento e interfaces
@@ -15,6 +16,8 @@ RoutingMatrix* MIDIRouter::routingMatrix = nullptr;
 EuclideanSequencer* MIDIRouter::euclideanSeq = nullptr;
 MidiClock* MIDIRouter::midiClock = nullptr;
 Adafruit_USBD_MIDI* MIDIRouter::usb_midi = nullptr;
+MidiTxScheduler MIDIRouter::dinTx;
+UsbMidiPacketizer MIDIRouter::usbTx;
 
 void MIDIRouter::begin() {
 	// Configura pinos de entrada/saída
@@ -29,18 +32,35 @@ void MIDIRouter::begin() {
 	Serial1.begin(MIDI_BAUD_RATE, SERIAL_8N1, DIN1_RX, DIN1_TX, false, 256);
 	Serial2.begin(MIDI_BAUD_RATE, SERIAL_8N1, DIN2_RX, DIN2_TX, false, 256);
 	Serial.begin(MIDI_BAUD_RATE, SERIAL_8N1, DIN3_RX, DIN3_TX, false, 256);
+	
+	// Todas as escritas DIN passam pelo agendador de transmissão
+	dinTx.attachPort(0, &Serial1);
+	dinTx.attachPort(1, &Serial2);
+	dinTx.attachPort(2, &Serial);
 }
 
 void MIDIRouter::sendToOutput(uint8_t outIndex, uint8_t b) {
 	switch (outIndex) {
-		case 0: Serial1.write(b); break;
-		case 1: Serial2.write(b); break;
-		case 2: Serial.write(b); break;
-		case 4: if (usb_midi) usb_midi->write(b); break;  // USB
+		case 0:
+		case 1:
+		case 2: dinTx.send(outIndex, MidiTxScheduler::PRIO_REALTIME, b, 0, 0); break;
+		case 4: usbTx.writeRealTime(b); break;  // USB (pacote direto, sem esperar pelo buffer)
 		default: break;  // Casos inválidos ou BLE (3) ignorados silenciosamente
 	}
 }
 
+void MIDIRouter::sendMessageToOutput(uint8_t outIndex, uint8_t status, uint8_t data1, uint8_t data2, uint8_t prio) {
+	if (outIndex < 3) {
+		MidiTxScheduler::Priority p = (prio == AUTO_PRIORITY)
+			? MidiTxScheduler::classify(status, data2)
+			: (MidiTxScheduler::Priority)prio;
+		dinTx.send(outIndex, p, status, data1, data2);
+	} else if (outIndex == 4) {
+		if (status >= 0xF8) usbTx.writeRealTime(status);
+		else usbTx.write(status, data1, data2);
+	}
+}
+
 // Buffer MIDI para cada entrada (reconstituição de mensagens)
 static uint8_t midiBuffer[3][3];        // 3 entradas, max 3 bytes por mensagem
 static uint8_t midiBufferLen[3] = {0};  // Número de bytes acumulados por entrada
@@ -57,11 +77,7 @@ void MIDIRouter::routeByteFromInput(uint8_t inIndex, uint8_t b) {
 			// RealTime message - roteia imediatamente sem afetar buffer
 			for (uint8_t outIndex = 0; outIndex < 5; ++outIndex) {
 				if (routingMatrix->get(inIndex, outIndex)) {
-					if (outIndex < 3) {
-						sendToOutput(outIndex, b);
-					} else if (outIndex == 4 && usb_midi) {
-						usb_midi->write(b);
-					}
+					if (outIndex < 3 || outIndex == 4) sendToOutput(outIndex, b);
 				}
 			}
 			return;
@@ -91,6 +107,13 @@ void MIDIRouter::routeByteFromInput(uint8_t inIndex, uint8_t b) {
 	if ((msgType >= 0x80 && msgType <= 0xBF) || (msgType >= 0xE0 && msgType <= 0xEF)) {
 		// Mensagens que usam 2 dados
 		msgComplete = (midiBufferLen[inIndex] == 3);
+	} else if (status == 0xF2) {
+		// Song Position Pointer: 2 dados (LSB, MSB)
+		if (midiBufferLen[inIndex] == 3) {
+			routeSongPosition(inIndex, midiBuffer[inIndex][1], midiBuffer[inIndex][2]);
+			midiBufferLen[inIndex] = 0;
+		}
+		return;
 	} else if (msgType == 0xF0) {
 		// System exclusive - não suportado por enquanto
 		midiBufferLen[inIndex] = 0;
@@ -147,21 +170,11 @@ void MIDIRouter::routeChannelMessage(uint8_t inIndex, uint8_t header, uint8_t da
 			if (!protocolEnabled) continue;  // Pula se protocolo desativado
             
 			if (outIndex < 3) {
-				// Saídas DIN: byte-by-byte
-				sendToOutput(outIndex, header);
-				sendToOutput(outIndex, data1);
-				if ((msgType >= 0x80 && msgType <= 0xBF) || (msgType >= 0xE0 && msgType <= 0xEF)) {
-					sendToOutput(outIndex, data2);
-				}
+				// Saídas DIN: thru numa só fila FIFO do agendador (mantém a ordem da entrada)
+				sendMessageToOutput(outIndex, header, data1, data2, MidiTxScheduler::PRIO_THRU);
 			} else {
-				// Saída USB: enviar mensagem completa
-				if (outIndex == 4 && usb_midi) {
-					usb_midi->write(header);
-					usb_midi->write(data1);
-					if ((msgType >= 0x80 && msgType <= 0xBF) || (msgType >= 0xE0 && msgType <= 0xEF)) {
-						usb_midi->write(data2);
-					}
-				}
+				// Saída USB: um pacote com a mensagem completa
+				if (outIndex == 4) sendMessageToOutput(outIndex, header, data1, data2);
 			}
 		}
 	}
@@ -171,9 +184,10 @@ void MIDIRouter::routeRealTimeMessage(uint8_t inIndex, uint8_t message) {
 	// MIDI Clock (0xF8) - apenas sincroniza internamente quando a fonte é permitida
 	if (message == 0xF8) {
 		if (midiClock && midiClock->isSlave()) {
-			// Só aceitar clock externo se o input for permitido pela seleção de Clock I/O
+			// Só aceitar clock externo se o input for permitido pela seleção de Clock I/O;
+			// o MidiClock arbitra entre as entradas permitidas
 			if (midiClock->isClockSourceEnabled(inIndex)) {
-				midiClock->receiveExternalClock();
+				midiClock->receiveExternalClock(inIndex);
 			}
 		}
 		return;  // Clock não é roteado para outputs
@@ -181,15 +195,23 @@ void MIDIRouter::routeRealTimeMessage(uint8_t inIndex, uint8_t message) {
 	
 	// MIDI Start (0xFA) - inicia o sequenciador em modo SLAVE
 	if (message == 0xFA) {
-		if (midiClock && midiClock->isSlave()) {
+		if (midiClock && midiClock->isSlave() && midiClock->acceptsTransportFrom(inIndex)) {
 			midiClock->start();
 		}
 		return;  // Start não é roteado para outputs quando em SLAVE
 	}
 	
+	// MIDI Continue (0xFB) - retoma da posição atual (definida por SPP) em modo SLAVE
+	if (message == 0xFB) {
+		if (midiClock && midiClock->isSlave() && midiClock->acceptsTransportFrom(inIndex)) {
+			midiClock->resume();
+		}
+		return;  // Continue não é roteado para outputs quando em SLAVE
+	}
+	
 	// MIDI Stop (0xFC) - para o sequenciador em modo SLAVE
 	if (message == 0xFC) {
-		if (midiClock && midiClock->isSlave()) {
+		if (midiClock && midiClock->isSlave() && midiClock->acceptsTransportFrom(inIndex)) {
 			midiClock->stop();
 		}
 		return;  // Stop não é roteado para outputs quando em SLAVE
@@ -199,47 +221,97 @@ void MIDIRouter::routeRealTimeMessage(uint8_t inIndex, uint8_t message) {
 	
 	for (uint8_t outIndex = 0; outIndex < 5; ++outIndex) {
 			if (routingMatrix->get(inIndex, outIndex)) {
-				if (outIndex < 3) {
-					sendToOutput(outIndex, message);
-				} else if (outIndex == 4 && usb_midi) {
-					usb_midi->write(message);
-				}
+				if (outIndex < 3 || outIndex == 4) sendToOutput(outIndex, message);
 			}
 	}
 }
 
+void MIDIRouter::routeSongPosition(uint8_t inIndex, uint8_t lsb, uint8_t msb) {
+	if ((lsb & 0x80) || (msb & 0x80)) return;
+	// Só reposiciona em SLAVE e a partir de uma fonte de clock permitida;
+	// o SPP é reenviado às saídas de clock pelo callback de locate
+	if (midiClock && midiClock->isSlave() && midiClock->acceptsTransportFrom(inIndex)) {
+		midiClock->locate((uint16_t)lsb | ((uint16_t)msb << 7));
+	}
+}
+
 // Envia mensagem real-time (Clock/Start/Stop) para os outputs configurados no MidiClock
-void MIDIRouter::sendRealtimeToClockOutputs(uint8_t message) {
+void MIDIRouter::sendRealtimeToClockOutputs(uint8_t message, uint8_t data1, uint8_t data2) {
 	if (!midiClock) return;
 	MidiClock::ClockIO io = midiClock->getClockIO();
 
 	// DIN outputs
 	if ((io & MidiClock::CLOCK_DIN) != 0) {
-		// Envia a todos os DINs (0..2)
+		// Envia a todos os DINs (0..2), na classe de tempo real
 		for (uint8_t out = 0; out < 3; ++out) {
-			sendToOutput(out, message);
+			sendMessageToOutput(out, message, data1, data2, MidiTxScheduler::PRIO_REALTIME);
 		}
 	}
 
 
 	// USB
 	if ((io & MidiClock::CLOCK_USB) != 0) {
-		if (usb_midi) {
-			usb_midi->write(message);
+		sendMessageToOutput(4, message, data1, data2);
+		usbTx.flush();  // transporte não espera pelo ciclo seguinte
+	}
+}
+
+void MIDIRouter::clockPulseCallback(uint32_t position) {
+	if (!midiClock) return;
+	MidiClock::ClockIO io = midiClock->getClockIO();
+
+	// 0xF8 por saída segundo a taxa/fase configurada no MidiClock
+	if ((io & MidiClock::CLOCK_DIN) != 0) {
+		for (uint8_t out = 0; out < 3; ++out) {
+			if (midiClock->isClockPulseDue(out, position)) sendToOutput(out, 0xF8);
+		}
+	}
+	if ((io & MidiClock::CLOCK_USB) != 0) {
+		if (midiClock->isClockPulseDue(4, position)) {
+			// Sai já, à frente do que estiver acumulado (como nas DIN)
+			usbTx.writeRealTime(0xF8);
 		}
 	}
 }
 
 void MIDIRouter::clockTickCallback() {
-	sendRealtimeToClockOutputs(0xF8);
+	// 0xF8 é enviado por `clockPulseCallback` (taxa por saída)
+	extern EuclideanMidiEngine euclidMidiEngine;
 	extern EuclideanHarmonicSequencer harmonicSeq;
+	euclidMidiEngine.onClockTick();
 	harmonicSeq.update();
 }
 
 void MIDIRouter::startCallback() {
 	sendRealtimeToClockOutputs(0xFA);
+	extern EuclideanMidiEngine euclidMidiEngine;
+	euclidMidiEngine.onTransportStart();
 }
 
 void MIDIRouter::stopCallback() {
 	sendRealtimeToClockOutputs(0xFC);
+	// Notas ainda a soar recebem o Note Off já (os pendentes na roda são ignorados)
+	extern EuclideanMidiEngine euclidMidiEngine;
+	euclidMidiEngine.onTransportStop();
+}
+
+void MIDIRouter::continueCallback() {
+	sendRealtimeToClockOutputs(0xFB);
+}
+
+void MIDIRouter::locateCallback(uint32_t tick) {
+	// Reposiciona os sequenciadores (O(tracks)) antes do próximo tick
+	extern EuclideanMidiEngine euclidMidiEngine;
+	extern EuclideanHarmonicSequencer harmonicSeq;
+	euclidMidiEngine.relocate(tick);
+	harmonicSeq.relocate(tick);
+
+	// Reenvia o SPP às saídas de clock (0xF2 LSB MSB)
+	uint16_t songPos = (uint16_t)(tick / 6);
+	sendRealtimeToClockOutputs(0xF2, songPos & 0x7F, (songPos >> 7) & 0x7F);
+}
+
+void MIDIRouter::scheduledEventCallback(uint32_t position) {
+	extern EuclideanMidiEngine euclidMidiEngine;
+	euclidMidiEngine.onScheduledEvent(position);
 }
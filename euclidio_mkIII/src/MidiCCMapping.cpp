@@ -235,18 +235,18 @@ void MidiCCMapping::processNote(uint8_t channel, uint8_t note, uint8_t velocity,
 
 // Funções de conversão de CC (0-127) para ranges apropriados
 int MidiCCMapping::mapCCToSteps(uint8_t value) {
-	// 0-127 → 1-32
-	return constrain(map(value, 0, 127, 1, 32), 1, 32);
+	// 0-127 → 1-64 (EuclideanPatterns::MAX_STEPS)
+	return EuclideanPatterns::clampSteps(map(value, 0, 127, EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS));
 }
 
 int MidiCCMapping::mapCCToHits(uint8_t value) {
-	// 0-127 → 1-32
-	return constrain(map(value, 0, 127, 1, 32), 1, 32);
+	// 0-127 → 1-64
+	return EuclideanPatterns::clampHits(map(value, 0, 127, EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS));
 }
 
 int MidiCCMapping::mapCCToOffset(uint8_t value) {
-	// 0-127 → 0-31
-	return map(value, 0, 127, 0, 31);
+	// 0-127 → 0-63
+	return map(value, 0, 127, 0, EuclideanPatterns::MAX_STEPS - 1);
 }
 
 int MidiCCMapping::mapCCToNote(uint8_t value) {
@@ -271,8 +271,8 @@ int MidiCCMapping::mapCCToResolution(uint8_t value) {
 }
 
 int MidiCCMapping::mapCCToTrack(uint8_t value) {
-	// 0-127 → 0-7 (8 tracks)
-	return map(value, 0, 127, 0, 7);
+	// 0-127 → 0..MAX_TRACKS-1
+	return map(value, 0, 127, 0, EuclideanSequencer::MAX_TRACKS - 1);
 }
 
 int MidiCCMapping::mapCCToTempo(uint8_t value) {
@@ -332,8 +332,8 @@ void MidiCCMapping::sendFeedback(EuclideanSequencer* seq, MidiClock* clock) {
 void MidiCCMapping::sendFeedbackSteps(EuclideanSequencer* seq) {
 	if (!seq) return;
 	uint8_t steps = seq->getSteps();
-	// Mapear 1-32 → 0-127
-	uint8_t ccValue = constrain(map(steps, 1, 32, 0, 127), 0, 127);
+	// Mapear 1-64 → 0-127
+	uint8_t ccValue = constrain(map(steps, EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS, 0, 127), 0, 127);
 	// Enviar via MIDI (será implementado via EuclideanMidiEngine)
 	// Por enquanto, apenas registramos a função
 }
@@ -341,15 +341,15 @@ void MidiCCMapping::sendFeedbackSteps(EuclideanSequencer* seq) {
 void MidiCCMapping::sendFeedbackHits(EuclideanSequencer* seq) {
 	if (!seq) return;
 	uint8_t hits = seq->getHits();
-	// Mapear 1-32 → 0-127
-	uint8_t ccValue = constrain(map(hits, 1, 32, 0, 127), 0, 127);
+	// Mapear 1-64 → 0-127
+	uint8_t ccValue = constrain(map(hits, EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS, 0, 127), 0, 127);
 }
 
 void MidiCCMapping::sendFeedbackOffset(EuclideanSequencer* seq) {
 	if (!seq) return;
 	uint8_t offset = seq->getOffset();
-	// Mapear 0-31 → 0-127
-	uint8_t ccValue = map(offset, 0, 31, 0, 127);
+	// Mapear 0-63 → 0-127
+	uint8_t ccValue = map(offset, 0, EuclideanPatterns::MAX_STEPS - 1, 0, 127);
 }
 
 void MidiCCMapping::sendFeedbackNote(EuclideanSequencer* seq) {
@@ -376,8 +376,8 @@ void MidiCCMapping::sendFeedbackResolution(EuclideanSequencer* seq) {
 void MidiCCMapping::sendFeedbackTrack(EuclideanSequencer* seq) {
 	if (!seq) return;
 	uint8_t track = seq->getSelectedPattern();
-	// Mapear 0-7 → 0-127
-	uint8_t ccValue = map(track, 0, 7, 0, 127);
+	// Mapear 0..MAX_TRACKS-1 → 0-127
+	uint8_t ccValue = map(track, 0, EuclideanSequencer::MAX_TRACKS - 1, 0, 127);
 }
 
 void MidiCCMapping::sendFeedbackPlay(EuclideanSequencer* seq, MidiClock* clock) {
@@ -1,5 +1,4 @@
 #include "MidiClock.h"
-#include "MIDIRouter.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -17,7 +16,11 @@ static void clockTaskWrapper(void* pv) {
 }
 
 MidiClock::MidiClock()
-  : timerHandle(nullptr), bpm(120.0), tickCount(0), currentPPQN(0), currentStep(0), ticksPerStep(6), isRunning(false), syncMode(MASTER), lastExternalClockTime(0), lastClockInterval(0), minClockInterval(65535), maxClockInterval(0), clockCount(0) {
+  : timerHandle(nullptr), bpm(120.0), tickCount(0), currentPPQN(0), currentStep(0), ticksPerStep(6), isRunning(false), syncMode(MASTER) {
+  for (uint8_t i = 0; i < NUM_CLOCK_SOURCES; ++i) {
+    sources[i] = ClockSourceStats{0, 0, 0xFFFFFFFF, 0, 0, 0, 0, 0};
+  }
+  outputStats = ClockSourceStats{0, 0, 0xFFFFFFFF, 0, 0, 0, 0, 0};
 }
 
 bool MidiClock::isClockSourceEnabled(uint8_t inIndex) const {
@@ -42,12 +45,15 @@ void MidiClock::begin(float initialBpm) {
   isRunning = false;
   
   // Cria timer usando o timer 0 da ESP32 (com frequência de 80MHz)
-  // Intervalo = (1000000 / (BPM/60 * 24)) microsegundos por tick
-  // BPM 120 = 2 beats/segundo = 48 ticks/segundo = ~20833 microsegundos
+  // O timer é armado evento a evento sobre a linha temporal de 960 PPQN:
+  // BPM 120 = 2 beats/segundo = 1920 subticks/segundo = ~520.83 microsegundos
   
   timerHandle = timerBegin(0, 80, true);  // Timer 0, prescaler 80 (1MHz)
   timerAttachInterrupt(timerHandle, &onTimerTick, true);
-  timerAlarmWrite(timerHandle, 20833, true);  // Valor padrão para 120 BPM
+  subtickPeriod = periodFromBPM(bpm);
+  pendingSubtickPeriod = subtickPeriod;
+  subtickPeriodAcc = 0;
+  timerAlarmWrite(timerHandle, subtickPeriod.q * SUBTICKS_PER_TICK, true);
 
   // Criar uma task dedicada para processar clock (pinning no Core 1)
   if (!clockTaskHandle) {
@@ -59,43 +65,286 @@ void MidiClock::begin(float initialBpm) {
 
 void MidiClock::setBPM(float newBpm) {
   if (newBpm > 0) {
-    bpm = newBpm;
-    
-    // Recalcula o intervalo do timer
-    // 1MHz clock (1 microsegundo por tick)
-    // Ticks necessários por segundo = BPM / 60 * 24
-    // Microsegundos por tick = 1000000 / (BPM/60 * 24)
-    uint32_t intervalUs = (uint32_t)(1000000.0 / (bpm / 60.0 * 24.0));
-    
-    if (timerHandle) {
-      timerAlarmWrite(timerHandle, intervalUs, true);
+    rampActive = false;
+    applyBPM(newBpm);
+  }
+}
+
+void MidiClock::applyBPM(float newBpm) {
+  bpm = newBpm;
+
+  // Em SLAVE o período do timer é controlado pelo TempoTracker
+  if (syncMode == MASTER) {
+    setSubtickPeriod(periodFromBPM(bpm));
+  }
+}
+
+bool MidiClock::startTempoRamp(float targetBpm, uint16_t beats, TempoRampShape shape, uint32_t atTick) {
+  if (syncMode != MASTER || targetBpm <= 0 || bpm <= 0) return false;
+  if (beats == 0) {
+    setBPM(targetBpm);
+    return true;
+  }
+  rampActive = false;
+  rampShape = shape;
+  rampStartBpm = bpm;
+  rampEndBpm = targetBpm;
+  rampStartTick = atTick ? atTick : tickCount;
+  rampTicks = (uint32_t)beats * PPQN_BASE;
+  rampActive = true;
+  return true;
+}
+
+void MidiClock::updateTempoRamp() {
+  if (!rampActive || syncMode != MASTER) return;
+  if ((int32_t)(tickCount - rampStartTick) < 0) return;
+
+  // Período do próximo tick: BPM no ponto da rampa onde esse tick termina
+  uint32_t idx = tickCount - rampStartTick + 1;
+  if (idx >= rampTicks) {
+    rampActive = false;
+    applyBPM(rampEndBpm);
+    return;
+  }
+  float t = (float)idx / (float)rampTicks;
+  float x;
+  if (rampShape == RAMP_EXPONENTIAL) {
+    x = rampStartBpm * powf(rampEndBpm / rampStartBpm, t);
+  } else {
+    x = rampStartBpm + (rampEndBpm - rampStartBpm) * t;
+  }
+  applyBPM(x);
+}
+
+MidiClock::SubtickPeriod MidiClock::periodFromBPM(float bpm) {
+  // Microsegundos por subtick = 1000000 / (BPM/60 * 960) = 6.25e7 / (BPM * 1000)
+  // BPM em milésimos como denominador: o resto nunca se perde
+  uint32_t milliBpm = (uint32_t)(bpm * 1000.0f + 0.5f);
+  if (milliBpm == 0) milliBpm = 1;
+  SubtickPeriod p;
+  p.q = US_PER_SUBTICK_MILLIBPM / milliBpm;
+  p.r = US_PER_SUBTICK_MILLIBPM % milliBpm;
+  p.den = milliBpm;
+  return p;
+}
+
+MidiClock::SubtickPeriod MidiClock::periodFromTickUs(float tickPeriodUs) {
+  // Período de tick estimado (SLAVE) com resolução de 1ns, repartido por 40 subticks
+  if (tickPeriodUs < 1.0f) tickPeriodUs = 1.0f;
+  uint32_t tickNs = (uint32_t)(tickPeriodUs * 1000.0f + 0.5f);
+  SubtickPeriod p;
+  p.den = 1000UL * SUBTICKS_PER_TICK;
+  p.q = tickNs / p.den;
+  p.r = tickNs % p.den;
+  return p;
+}
+
+void MidiClock::setSubtickPeriod(const SubtickPeriod& period) {
+  portENTER_CRITICAL(&timerMux);
+  pendingSubtickPeriod = period;
+  subtickPeriodPending = true;
+  portEXIT_CRITICAL(&timerMux);
+}
+
+uint32_t MidiClock::getTickPeriodUs() {
+  // O período pendente é sempre o mais recente (o ISR adota-o no próximo evento)
+  portENTER_CRITICAL(&timerMux);
+  SubtickPeriod p = pendingSubtickPeriod;
+  portEXIT_CRITICAL(&timerMux);
+  return p.q * SUBTICKS_PER_TICK + (p.r * SUBTICKS_PER_TICK) / p.den;
+}
+
+uint32_t MidiClock::spanDurationUs(uint32_t subticks) {
+  if (subtickPeriodPending) {
+    subtickPeriod = pendingSubtickPeriod;
+    subtickPeriodPending = false;
+    if (subtickPeriodAcc >= subtickPeriod.den) subtickPeriodAcc %= subtickPeriod.den;
+  }
+  // n * (q + r/den): parte inteira direta, resto acumulado para o evento seguinte
+  uint32_t acc = subtickPeriodAcc + subticks * subtickPeriod.r;
+  subtickPeriodAcc = acc % subtickPeriod.den;
+  return subticks * subtickPeriod.q + acc / subtickPeriod.den;
+}
+
+uint32_t MidiClock::armNextEvent() {
+  // Próximo evento: ponto seguinte da grelha de saída (fronteira de tick, ou
+  // meio tick com saídas x2) ou evento agendado antes dele
+  uint32_t grid = gridSubticks;
+  uint32_t target = (position / grid + 1) * grid;
+  uint32_t sched = nextScheduledPos;
+  if (sched > position && sched < target) target = sched;
+  armedSpan = target - position;
+  return spanDurationUs(armedSpan);
+}
+
+void MidiClock::armTimer() {
+  if (!timerHandle) return;
+  portENTER_CRITICAL(&timerMux);
+  subtickPeriodAcc = 0;
+  uint32_t firstUs = armNextEvent();
+  portEXIT_CRITICAL(&timerMux);
+  timerWrite(timerHandle, 0);
+  timerAlarmWrite(timerHandle, firstUs, true);
+  timerAlarmEnable(timerHandle);
+}
+
+bool MidiClock::scheduleAt(uint32_t pos) {
+  bool ok = false;
+  portENTER_CRITICAL(&timerMux);
+  if ((int32_t)(pos - position) > 0 && scheduledCount < MAX_SCHEDULED_EVENTS) {
+    // Inserção ordenada (agenda pequena)
+    uint8_t i = scheduledCount;
+    while (i > 0 && scheduled[i - 1] > pos) {
+      scheduled[i] = scheduled[i - 1];
+      --i;
+    }
+    scheduled[i] = pos;
+    scheduledCount++;
+    nextScheduledPos = scheduled[0];
+    ok = true;
+  }
+  portEXIT_CRITICAL(&timerMux);
+  return ok;
+}
+
+void MidiClock::processScheduledEvents() {
+  for (;;) {
+    uint32_t due = 0;
+    bool fire = false;
+    portENTER_CRITICAL(&timerMux);
+    if (scheduledCount > 0 && (int32_t)(position - scheduled[0]) >= 0) {
+      due = scheduled[0];
+      for (uint8_t i = 1; i < scheduledCount; ++i) scheduled[i - 1] = scheduled[i];
+      scheduledCount--;
+      nextScheduledPos = scheduledCount ? scheduled[0] : 0xFFFFFFFF;
+      fire = true;
     }
+    portEXIT_CRITICAL(&timerMux);
+    if (!fire) break;
+    if (onScheduledEvent) onScheduledEvent(due);
+  }
+}
+
+uint16_t MidiClock::rateIntervalSubticks(uint8_t rate) {
+  switch (rate) {
+    case RATE_X2:   return SUBTICKS_PER_TICK / 2;
+    case RATE_DIV2: return SUBTICKS_PER_TICK * 2;
+    case RATE_DIV4: return SUBTICKS_PER_TICK * 4;
+    default:        return SUBTICKS_PER_TICK;
+  }
+}
+
+void MidiClock::updateOutputGrid() {
+  // Grelha = menor intervalo entre pulsos (divide sempre o tick: fronteiras mantêm-se)
+  uint32_t grid = SUBTICKS_PER_TICK;
+  for (uint8_t i = 0; i < NUM_CLOCK_OUTPUTS; ++i) {
+    uint16_t interval = rateIntervalSubticks(outputClockRate[i]);
+    if (interval < grid) grid = interval;
+  }
+  portENTER_CRITICAL(&timerMux);
+  gridSubticks = grid;
+  portEXIT_CRITICAL(&timerMux);
+}
+
+void MidiClock::setOutputClockRate(uint8_t outIndex, ClockRate rate) {
+  if (outIndex >= NUM_CLOCK_OUTPUTS || rate > RATE_DIV4) return;
+  outputClockRate[outIndex] = rate;
+  updateOutputGrid();
+}
+
+void MidiClock::setOutputClockOffset(uint8_t outIndex, int8_t ticks) {
+  if (outIndex >= NUM_CLOCK_OUTPUTS) return;
+  outputClockOffset[outIndex] = ticks;
+}
+
+bool MidiClock::isClockPulseDue(uint8_t outIndex, uint32_t pos) const {
+  if (outIndex >= NUM_CLOCK_OUTPUTS) return false;
+  int32_t interval = rateIntervalSubticks(outputClockRate[outIndex]);
+  // Fase da saída dentro do intervalo (offsets negativos equivalem a avançar)
+  int32_t phase = ((int32_t)outputClockOffset[outIndex] * SUBTICKS_PER_TICK) % interval;
+  if (phase < 0) phase += interval;
+  return (int32_t)(pos % (uint32_t)interval) == phase;
+}
+
+void MidiClock::setSyncMode(SyncMode mode) {
+  if (mode == syncMode) return;
+  syncMode = mode;
+  resetSlaveTracking();
+  if (!timerHandle) return;
+
+  if (mode == MASTER) {
+    // Retoma o timer interno com o BPM atual
+    setBPM(bpm);
+    if (isRunning) armTimer();
+  } else {
+    // Até haver lock, os ticks seguem diretamente o clock externo
+    timerAlarmDisable(timerHandle);
   }
 }
 
+void MidiClock::resetSlaveTracking() {
+  portENTER_CRITICAL(&timerMux);
+  slaveExtTicks = 0;
+  slaveGenTicks = 0;
+  lastGenTickUs = 0;
+  slaveTimerActive = false;
+  portEXIT_CRITICAL(&timerMux);
+}
+
 void MidiClock::start() {
   if (!isRunning) {
-    tickCount = 0;
-    currentPPQN = 0;
-    currentStep = 0;
+    reset();
+    resetSlaveTracking();
+    // Nova fase: o PLL volta a bloquear a partir dos clocks que seguem o Start
+    tempoTracker.reset();
+    // Start entra no ring antes de qualquer tick: 0xFA sai sempre antes do primeiro 0xF8
+    portENTER_CRITICAL(&timerMux);
+    pushRealTimeEvent(RT_START, micros(), 0);
     isRunning = true;
-    if (timerHandle && syncMode == MASTER) {
-      timerAlarmEnable(timerHandle);
+    portEXIT_CRITICAL(&timerMux);
+    if (syncMode == MASTER) {
+      armTimer();
     }
-    if (onStart) {
-      onStart();
+    notifyClockTask();
+  }
+}
+
+void MidiClock::resume() {
+  if (!isRunning) {
+    resetSlaveTracking();
+    // Contadores e posição mantêm-se: o primeiro tick continua do ponto atual
+    portENTER_CRITICAL(&timerMux);
+    pushRealTimeEvent(RT_CONTINUE, micros(), position);
+    isRunning = true;
+    portEXIT_CRITICAL(&timerMux);
+    if (syncMode == MASTER) {
+      armTimer();
     }
+    notifyClockTask();
   }
 }
 
+void MidiClock::locate(uint16_t songPos) {
+  uint32_t pos = (uint32_t)songPos * TICKS_PER_SONG_POS * SUBTICKS_PER_TICK;
+  portENTER_CRITICAL(&timerMux);
+  // Eventos agendados pertencem à linha temporal anterior
+  position = pos;
+  scheduledCount = 0;
+  nextScheduledPos = 0xFFFFFFFF;
+  pushRealTimeEvent(RT_LOCATE, micros(), pos);
+  portEXIT_CRITICAL(&timerMux);
+  notifyClockTask();
+}
+
 void MidiClock::stop() {
   if (isRunning && timerHandle) {
-    isRunning = false;
     timerAlarmDisable(timerHandle);
-    
-    if (onStop) {
-      onStop();
-    }
+    portENTER_CRITICAL(&timerMux);
+    isRunning = false;
+    pushRealTimeEvent(RT_STOP, micros(), position);
+    portEXIT_CRITICAL(&timerMux);
+    resetSlaveTracking();
+    notifyClockTask();
   }
 }
 
@@ -103,122 +352,365 @@ void MidiClock::reset() {
   tickCount = 0;
   currentPPQN = 0;
   currentStep = 0;
+  portENTER_CRITICAL(&timerMux);
+  position = 0;
+  scheduledCount = 0;
+  nextScheduledPos = 0xFFFFFFFF;
+  portEXIT_CRITICAL(&timerMux);
 }
 
 void MidiClock::tickHandler() {
-  // Em modo SLAVE, não usar timer interno
-  if (syncMode == SLAVE) {
-    return;
+  bool notify = false;
+  portENTER_CRITICAL_ISR(&timerMux);
+  if (isRunning) {
+    uint32_t target = position + armedSpan;
+    bool isTick = (target % SUBTICKS_PER_TICK) == 0;
+    bool advance = true;
+    // Em modo SLAVE o timer segue a estimativa do TempoTracker. Se a fonte
+    // externa desaparecer, gera no máximo SLAVE_FREEWHEEL_TICKS e depois espera.
+    uint32_t now = isTick ? micros() : 0;
+    if (isTick && syncMode == SLAVE) {
+      advance = slaveTimerActive && (slaveGenTicks < slaveExtTicks + SLAVE_FREEWHEEL_TICKS);
+      if (advance) {
+        slaveGenTicks++;
+        lastGenTickUs = now;
+      }
+    }
+    if (advance) {
+      position = target;
+      // Minimizar trabalho no ISR: apenas publica o tick (com instante) no ring
+      bool isGrid = !isTick && (target % gridSubticks) == 0;
+      if (isTick) {
+        pushRealTimeEvent(RT_TICK, now, target);
+      } else if (isGrid) {
+        pushRealTimeEvent(RT_GRID, micros(), target);
+      }
+      notify = isTick || isGrid || target == nextScheduledPos;
+    }
   }
+  // Duração até ao próximo evento escrita na fronteira deste:
+  // mudanças de BPM nunca encurtam/alongam um tick a meio
+  timerAlarmWrite(timerHandle, armNextEvent(), true);
+  portEXIT_CRITICAL_ISR(&timerMux);
+  if (!notify) return;
 
-  // Minimizar trabalho no ISR: apenas marca ticks pendentes para processamento
-  if (isRunning) {
-    pendingClockTicks++;
-    // Notificar a task dedicada (se criada) de forma segura para ISR
-    if (clockTaskHandle) {
-      BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-      vTaskNotifyGiveFromISR(clockTaskHandle, &xHigherPriorityTaskWoken);
-      if (xHigherPriorityTaskWoken) portYIELD_FROM_ISR();
+  // Notificar a task dedicada (se criada) de forma segura para ISR
+  if (clockTaskHandle) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(clockTaskHandle, &xHigherPriorityTaskWoken);
+    if (xHigherPriorityTaskWoken) portYIELD_FROM_ISR();
+  }
+}
+
+void MidiClock::updateClockStats(ClockSourceStats& src, uint32_t nowUs) {
+  if (src.clockCount > 0) {
+    uint32_t interval = nowUs - src.lastClockUs;
+    src.lastInterval = interval;
+    if (interval < src.minInterval) src.minInterval = interval;
+    if (interval > src.maxInterval) src.maxInterval = interval;
+
+    if (src.avgInterval == 0) {
+      src.avgInterval = interval;
+    } else if (interval > src.avgInterval * SOURCE_TIMEOUT_PERIODS) {
+      // A fonte parou e voltou: não contamina a média, recomeça a contagem de estabilidade
+      src.consistentCount = 0;
+    } else {
+      // Médias móveis inteiras (peso 1/8)
+      int32_t diff = (int32_t)(interval - src.avgInterval);
+      uint32_t dev = (diff < 0) ? (uint32_t)(-diff) : (uint32_t)diff;
+      src.avgInterval += diff / 8;
+      src.avgJitter += ((int32_t)dev - (int32_t)src.avgJitter) / 8;
+      if (dev * 4 < src.avgInterval) {
+        if (src.consistentCount < 255) src.consistentCount++;
+      } else {
+        src.consistentCount = 0;
+      }
     }
   }
+  src.lastClockUs = nowUs;
+  src.clockCount++;
 }
 
-void MidiClock::receiveExternalClock() {
+bool MidiClock::isSourceAlive(uint8_t inIndex, uint32_t nowUs) const {
+  const ClockSourceStats& src = sources[inIndex];
+  if (src.clockCount == 0) return false;
+  uint32_t timeout = src.avgInterval ? src.avgInterval * SOURCE_TIMEOUT_PERIODS : SOURCE_TIMEOUT_US;
+  return (uint32_t)(nowUs - src.lastClockUs) < timeout;
+}
+
+bool MidiClock::arbitrateClock(uint8_t inIndex, uint32_t nowUs) {
+  if (inIndex == primarySource) return true;
+  if (primarySource != NO_CLOCK_SOURCE) {
+    // Primária ainda ativa: esta fonte só contribui para as estatísticas
+    if (isSourceAlive(primarySource, nowUs)) return false;
+    // Failover apenas para uma fonte já estável; a fase da nova fonte não tem
+    // relação com a anterior, por isso o TempoTracker recomeça o lock
+    if (!isSourceStable(inIndex)) return false;
+    clockFailovers++;
+    tempoTracker.reset();
+  }
+  primarySource = inIndex;
+  return true;
+}
+
+bool MidiClock::acceptsTransportFrom(uint8_t inIndex) const {
+  if (!isClockSourceEnabled(inIndex)) return false;
+  if (primarySource == NO_CLOCK_SOURCE || primarySource == inIndex) return true;
+  return !isSourceAlive(primarySource, micros());
+}
+
+void MidiClock::receiveExternalClock(uint8_t inIndex) {
   // Função chamada quando recebe 0xF8 (Clock) de uma porta MIDI
+  if (inIndex >= NUM_CLOCK_SOURCES) return;
   uint32_t now = micros();
 
-  // Calcula intervalo desde o último clock (em micros para melhor resolução)
-  if (lastExternalClockTime > 0) {
-    lastClockInterval = (uint32_t)(now - lastExternalClockTime);
+  updateClockStats(sources[inIndex], now);
+  if (!arbitrateClock(inIndex, now)) return;
 
-    // Atualiza min/max para detecção de jitter (converte para ms-range values if needed)
-    if (lastClockInterval < minClockInterval) {
-      minClockInterval = (uint16_t)lastClockInterval;
-    }
-    if (lastClockInterval > maxClockInterval) {
-      maxClockInterval = (uint16_t)lastClockInterval;
+  if (syncMode != SLAVE) return;
+
+  // PLL: atualiza estimativa de tempo (também com o transporte parado)
+  uint8_t ticks = tempoTracker.onClock(now);
+  if (!isRunning || ticks == 0) return;
+
+  bool locked = tempoTracker.isLocked();
+  bool regen = clockOutMode == CLOCK_OUT_REGEN;
+  bool catchUp = false;
+  bool startTimer = false;
+  uint16_t emit = 0;
+
+  portENTER_CRITICAL(&timerMux);
+  slaveExtTicks += ticks;
+  int32_t behind = (int32_t)(slaveExtTicks - slaveGenTicks);
+  uint32_t sinceLastGen = now - lastGenTickUs;
+  bool timerActive = slaveTimerActive;
+  portEXIT_CRITICAL(&timerMux);
+
+  if (!locked || !timerActive || !regen) {
+    // Sem lock (ou primeiro clock após Start, ou modo eco): ticks seguem diretamente os clocks recebidos
+    catchUp = true;
+    startTimer = locked && regen;
+  } else {
+    // Erro de fase em ticks: posição externa menos posição gerada (com fração do tick atual)
+    float frac = (float)sinceLastGen / tempoTracker.getPeriodUs();
+    if (frac > 1.0f) frac = 1.0f;
+    float phaseError = (float)behind - frac;
+    if (phaseError > SLAVE_RESYNC_TICKS) {
+      // Demasiado atrasado: ressincroniza de imediato
+      catchUp = true;
+      phaseError = 0.0f;
     }
+    setSubtickPeriod(periodFromTickUs(tempoTracker.correctedPeriodUs(phaseError)));
   }
 
-  lastExternalClockTime = now;
-  clockCount++;
+  portENTER_CRITICAL(&timerMux);
+  if (catchUp && (int32_t)(slaveExtTicks - slaveGenTicks) > 0) {
+    emit = (uint16_t)(slaveExtTicks - slaveGenTicks);
+    slaveGenTicks = slaveExtTicks;
+    lastGenTickUs = now;
+    // Linha temporal salta tick a tick até à fronteira do último tick emitido
+    uint32_t pos = (position / SUBTICKS_PER_TICK) * SUBTICKS_PER_TICK;
+    for (uint16_t i = 0; i < emit; ++i) {
+      pos += SUBTICKS_PER_TICK;
+      pushRealTimeEvent(RT_TICK, now, pos);
+    }
+    position = pos;
+  }
+  if (startTimer) {
+    slaveTimerActive = true;
+  } else if (!locked || !regen) {
+    slaveTimerActive = false;
+  }
+  portEXIT_CRITICAL(&timerMux);
 
-  // Minimizar trabalho: marcar tick pendente e processar no loop
-  if (syncMode == SLAVE && isRunning) {
-    pendingClockTicks++;
-    // Notificar a task dedicada (se criada)
-    if (clockTaskHandle) {
-      xTaskNotifyGive(clockTaskHandle);
+  if (timerHandle) {
+    if (startTimer) {
+      // Próximo tick interno um período após este clock
+      setSubtickPeriod(periodFromTickUs(tempoTracker.getPeriodUs()));
+      armTimer();
+    } else if ((!locked || !regen) && timerActive) {
+      timerAlarmDisable(timerHandle);
     }
   }
+
+  // Notificar a task dedicada (se criada)
+  if (emit > 0) notifyClockTask();
 }
 
 void MidiClock::startHandler() {
-  // marcar start pendente para processamento no loop
+  // Start publica RT_START no ring; o 0xFA é enviado pela task do clock
   start();
-  pendingStartFlag = true;
 }
 
 void MidiClock::stopHandler() {
-  // marcar stop pendente para processamento no loop
+  // Stop publica RT_STOP no ring; o 0xFC é enviado pela task do clock
   stop();
-  pendingStopFlag = true;
+}
+
+bool MidiClock::pushRealTimeEvent(uint8_t type, uint32_t timeUs, uint32_t pos) {
+  // Produtor único (serializado por timerMux): escreve o slot e só depois publica o head
+  uint8_t head = rtHead.load(std::memory_order_relaxed);
+  uint8_t next = (head + 1) & (RT_RING_SIZE - 1);
+  if (next == rtTail.load(std::memory_order_acquire)) {
+    rtDroppedEvents++;
+    return false;
+  }
+  rtRing[head].type = type;
+  rtRing[head].timeUs = timeUs;
+  rtRing[head].position = pos;
+  rtHead.store(next, std::memory_order_release);
+  return true;
+}
+
+void MidiClock::notifyClockTask() {
+  if (clockTaskHandle) xTaskNotifyGive(clockTaskHandle);
+}
+
+uint8_t MidiClock::pendingRealTimeEvents() const {
+  return (rtHead.load(std::memory_order_acquire) - rtTail.load(std::memory_order_relaxed)) & (RT_RING_SIZE - 1);
+}
+
+void MidiClock::advanceTick(bool dispatch) {
+  // Atualiza contadores internos
+  tickCount++;
+  currentPPQN++;
+
+  // Atualiza passo a cada ticksPerStep ticks PPQN
+  if (currentPPQN >= ticksPerStep) {
+    currentPPQN = 0;
+    currentStep++;
+    if (dispatch && onStepStart) onStepStart(currentStep);
+  }
+
+  // Rampa de tempo segue o tick mesmo quando este é descartado (DROP)
+  updateTempoRamp();
+
+  // Pulsos de clock por saída e callback de clock (seguro no contexto de task);
+  // getEventTime() dá o instante do tick. Os pulsos saem mesmo num tick
+  // descartado (DROP): os escravos contam 0xF8 e ficariam um tick atrás.
+  if (onClockPulse) onClockPulse(currentEvent.position);
+  if (dispatch && onClockTick) onClockTick();
+
+  // NOTE: envio para saídas de clock é feito pelo callback `onClockTick`
+  // (ex.: `MIDIRouter::clockTickCallback`) para evitar duplicação.
 }
 
 void MidiClock::processPendingRealTime() {
-  // Leitura atômica das flags/counters
-  noInterrupts();
-  uint16_t ticks = pendingClockTicks;
-  bool hasStart = pendingStartFlag;
-  bool hasStop = pendingStopFlag;
-  pendingClockTicks = 0;
-  pendingStartFlag = false;
-  pendingStopFlag = false;
-  interrupts();
-
-  // Enviar Start/Stop/Clock através do MIDIRouter (contexto seguro)
-  if (hasStart) {
-    MIDIRouter::sendRealtimeToClockOutputs(0xFA);
-  }
-  if (hasStop) {
-    MIDIRouter::sendRealtimeToClockOutputs(0xFC);
-  }
-
-  // Processar todos os clock ticks pendentes: atualizar estado interno
-  // e notificar callbacks no contexto de loop (seguro para I/O)
-  for (uint16_t i = 0; i < ticks; ++i) {
-    // Atualiza contadores internos
-    tickCount++;
-    currentPPQN++;
-
-    // Atualiza passo a cada ticksPerStep ticks PPQN
-    if (currentPPQN >= ticksPerStep) {
-      currentPPQN = 0;
-      currentStep++;
-      if (onStepStart) onStepStart(currentStep);
-    }
+  // Consumidor único: lê o ring sem bloquear interrupções e processa os
+  // eventos pela ordem em que ocorreram (Start/Stop intercalados com ticks)
+  uint16_t burst = 0;
+  for (;;) {
+    uint8_t tail = rtTail.load(std::memory_order_relaxed);
+    if (tail == rtHead.load(std::memory_order_acquire)) break;
+    const RealTimeEvent& ev = rtRing[tail];
+
+    if (ev.type == RT_TICK) {
+      uint32_t now = micros();
+      uint32_t lateness = now - ev.timeUs;
+      bool late = lateness > LATE_TICK_US;
+      uint8_t backlog = pendingRealTimeEvents();
 
-    // Callback de clock (seguro no contexto de loop)
-    if (onClockTick) onClockTick();
+      // SPREAD: ticks atrasados saem espaçados até ao próximo tick esperado
+      // (o evento fica no ring; a task volta a tentar no próximo tick do RTOS).
+      // Só dentro de um episódio: fora dele nextSpreadUs pode ter dado a volta.
+      if (!late || backlog <= 1) spreading = false;
+      if (spreading && catchUpPolicy == CATCHUP_SPREAD &&
+          (int32_t)(now - nextSpreadUs) < 0) {
+        break;
+      }
 
-    // NOTE: envio para saídas de clock é feito pelo callback `onClockTick`
-    // (ex.: `MIDIRouter::clockTickCallback`) para evitar duplicação.
+      currentEvent = ev;
+      rtTail.store((tail + 1) & (RT_RING_SIZE - 1), std::memory_order_release);
+
+      if (lateness > maxTaskLatenessUs) maxTaskLatenessUs = lateness;
+      if (lastTickEventUs != 0) tickIntervalUs = currentEvent.timeUs - lastTickEventUs;
+      lastTickEventUs = currentEvent.timeUs;
+      updateClockStats(outputStats, currentEvent.timeUs);
+
+      if (late) {
+        lateTicks++;
+        // DROP: só o tick mais recente é renderizado; os restantes avançam os
+        // contadores e enviam os seus 0xF8, para que o passo e os escravos
+        // continuem alinhados com a linha temporal
+        if (catchUpPolicy == CATCHUP_DROP && backlog > 1) {
+          droppedLateTicks++;
+          advanceTick(false);
+          continue;
+        }
+        if (catchUpPolicy == CATCHUP_SPREAD && backlog > 1) {
+          nextSpreadUs = now + tickIntervalUs / backlog;
+          spreading = true;
+        }
+      }
+
+      advanceTick(true);
+      burst++;
+      continue;
+    }
+
+    currentEvent = ev;
+    rtTail.store((tail + 1) & (RT_RING_SIZE - 1), std::memory_order_release);
+    switch (currentEvent.type) {
+      case RT_START:
+        lastTickEventUs = 0;
+        spreading = false;
+        if (onStart) onStart();
+        break;
+      case RT_STOP:
+        if (onStop) onStop();
+        break;
+      case RT_CONTINUE:
+        lastTickEventUs = 0;
+        if (onContinue) onContinue();
+        break;
+      case RT_LOCATE:
+        // Estado equivalente a ter tocado continuamente até à nova posição
+        lastTickEventUs = 0;
+        tickCount = currentEvent.position / SUBTICKS_PER_TICK;
+        currentPPQN = tickCount % ticksPerStep;
+        currentStep = (uint8_t)(tickCount / ticksPerStep);
+        if (onLocate) onLocate(tickCount);
+        break;
+      case RT_GRID:
+        if (onClockPulse) onClockPulse(currentEvent.position);
+        break;
+    }
   }
+
+  if (burst > 1) tickBursts++;
+  if (burst > maxTickBurst) maxTickBurst = burst;
+
+  // Eventos agendados entre ticks (posição 960 PPQN já atingida)
+  processScheduledEvents();
 }
 
 void MidiClock::clockTaskLoop() {
-  // Task principal: espera notificação da ISR e processa ticks pendentes
+  // Task principal: espera notificação da ISR e processa eventos pendentes
   for (;;) {
-    // Aguarda notificação (ulTaskNotifyTake decrementa o contador de notificações)
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    // Processar quaisquer ticks/start/stop pendentes de forma atômica
+    // Com eventos ainda no ring (SPREAD) acorda no próximo tick do RTOS
+    TickType_t wait = pendingRealTimeEvents() ? 1 : portMAX_DELAY;
+    ulTaskNotifyTake(pdTRUE, wait);
+    // Consumir todos os eventos de tempo real publicados no ring
     processPendingRealTime();
   }
 }
 
 void MidiClock::resetJitterStats() {
-  minClockInterval = 65535;
-  maxClockInterval = 0;
-  clockCount = 0;
-  lastClockInterval = 0;
+  // Mantém médias, estabilidade e contagem (usadas na arbitragem); limpa min/max
+  for (uint8_t i = 0; i < NUM_CLOCK_SOURCES; ++i) {
+    sources[i].minInterval = 0xFFFFFFFF;
+    sources[i].maxInterval = 0;
+    sources[i].lastInterval = 0;
+  }
+  outputStats.minInterval = 0xFFFFFFFF;
+  outputStats.maxInterval = 0;
+  outputStats.lastInterval = 0;
+}
+
+void MidiClock::resetTimingStats() {
+  lateTicks = 0;
+  droppedLateTicks = 0;
+  tickBursts = 0;
+  maxTickBurst = 0;
+  maxTaskLatenessUs = 0;
 }
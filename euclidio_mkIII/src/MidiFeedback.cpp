@@ -32,23 +32,20 @@ void MidiFeedback::midiDispatchTask(void* param) {
 	FeedbackMessage msg;
 	while (true) {
 		if (feedbackQueue && xQueueReceive(feedbackQueue, &msg, pdMS_TO_TICKS(50)) == pdTRUE) {
-			// USB
-			if (usb_midi) {
-				usb_midi->write(msg.status);
-				usb_midi->write(msg.data1);
-				usb_midi->write(msg.data2);
-			}
-			// BLE removed
-			// DIN outputs (send to all configured DINs)
-			MIDIRouter::sendToOutput(0, msg.status);
-			MIDIRouter::sendToOutput(0, msg.data1);
-			MIDIRouter::sendToOutput(0, msg.data2);
-			MIDIRouter::sendToOutput(1, msg.status);
-			MIDIRouter::sendToOutput(1, msg.data1);
-			MIDIRouter::sendToOutput(1, msg.data2);
-			MIDIRouter::sendToOutput(2, msg.status);
-			MIDIRouter::sendToOutput(2, msg.data1);
-			MIDIRouter::sendToOutput(2, msg.data2);
+			// Esvazia o que já estiver na fila: um só flush USB por rajada de feedback
+			do {
+				// USB
+				if (usb_midi) {
+					MIDIRouter::sendMessageToOutput(4, msg.status, msg.data1, msg.data2);
+				}
+				// BLE removed
+				// DIN outputs (send to all configured DINs)
+				// Classe CC do agendador DIN: reduzida em sobrecarga, nunca atrasa notas
+				MIDIRouter::sendMessageToOutput(0, msg.status, msg.data1, msg.data2, MidiTxScheduler::PRIO_CC);
+				MIDIRouter::sendMessageToOutput(1, msg.status, msg.data1, msg.data2, MidiTxScheduler::PRIO_CC);
+				MIDIRouter::sendMessageToOutput(2, msg.status, msg.data1, msg.data2, MidiTxScheduler::PRIO_CC);
+			} while (xQueueReceive(feedbackQueue, &msg, 0) == pdTRUE);
+			MIDIRouter::flushUsbOutput();
 		} else {
 			vTaskDelay(pdMS_TO_TICKS(1));
 		}
@@ -107,18 +104,18 @@ void MidiFeedback::sendAllFeedbackForced(EuclideanSequencer* seq, MidiClock* clo
 
 	// Steps
 	uint8_t steps = seq->getSteps();
-	uint8_t stepsCC = constrain(map(steps, 1, 32, 0, 127), 0, 127);
+	uint8_t stepsCC = constrain(map(steps, EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS, 0, 127), 0, 127);
 	sendDirect(20, stepsCC); lastStepsCC = stepsCC;
 
 	// Hits
 	uint8_t hits = seq->getHits();
-	uint8_t hitsCC = constrain(map(hits, 1, 32, 0, 127), 0, 127);
+	uint8_t hitsCC = constrain(map(hits, EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS, 0, 127), 0, 127);
 	sendDirect(21, hitsCC); lastHitsCC = hitsCC;
 
 	// Offset (user-facing)
 	uint8_t offset = seq->getOffset();
 	uint8_t offsetUser = offset + 1;
-	uint8_t offsetCC = map(offsetUser, 1, 32, 0, 127);
+	uint8_t offsetCC = map(offsetUser, 1, EuclideanPatterns::MAX_STEPS, 0, 127);
 	sendDirect(22, offsetCC); lastOffsetCC = offsetCC;
 
 	// Note
@@ -132,7 +129,7 @@ void MidiFeedback::sendAllFeedbackForced(EuclideanSequencer* seq, MidiClock* clo
 	sendDirect(25, resCC); lastResolutionCC = resCC;
 
 	// Track
-	uint8_t track = seq->getSelectedPattern(); uint8_t trackCC = map(track, 0, 7, 0, 127);
+	uint8_t track = seq->getSelectedPattern(); uint8_t trackCC = map(track, 0, EuclideanSequencer::MAX_TRACKS - 1, 0, 127);
 	sendDirect(26, trackCC); lastTrackCC = trackCC;
 
 	// Channel
@@ -185,12 +182,12 @@ void MidiFeedback::sendAllHarmonicFeedbackForced(EuclideanHarmonicSequencer* hse
 	uint8_t scale = (uint8_t)hseq->getScaleType(); sendDirect(41, scale);
 	// CC 42: Mode (0 = chords, 1 = notes)
 	uint8_t mode = (uint8_t)hseq->getDistributionMode(); sendDirect(42, mode);
-	// CC 43: Steps (1..32 -> 0..127)
-	uint8_t steps = hseq->getSteps(); uint8_t stepsCC = constrain(map(steps, 1, 32, 0, 127), 0, 127); sendDirect(43, stepsCC);
+	// CC 43: Steps (1..64 -> 0..127)
+	uint8_t steps = hseq->getSteps(); uint8_t stepsCC = constrain(map(steps, EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS, 0, 127), 0, 127); sendDirect(43, stepsCC);
 	// CC 44: Hits
-	uint8_t hits = hseq->getHits(); uint8_t hitsCC = constrain(map(hits, 1, 32, 0, 127), 0, 127); sendDirect(44, hitsCC);
-	// CC 45: Offset (0..31)
-	uint8_t off = hseq->getOffset(); uint8_t offCC = constrain(map(off, 0, 31, 0, 127), 0, 127); sendDirect(45, offCC);
+	uint8_t hits = hseq->getHits(); uint8_t hitsCC = constrain(map(hits, EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS, 0, 127), 0, 127); sendDirect(44, hitsCC);
+	// CC 45: Offset (0..63)
+	uint8_t off = hseq->getOffset(); uint8_t offCC = constrain(map(off, 0, EuclideanPatterns::MAX_STEPS - 1, 0, 127), 0, 127); sendDirect(45, offCC);
 	// CC 46: Polyphony (1..MAX_POLYPHONY)
 	uint8_t poly = hseq->getPolyphony(); uint8_t polyCC = constrain(map(poly, 1, (int)EuclideanHarmonicSequencer::MAX_POLYPHONY, 0, 127), 0, 127); sendDirect(46, polyCC);
 	// CC 47: Velocity
@@ -230,10 +227,10 @@ void MidiFeedback::sendAllHarmonicFeedback(EuclideanHarmonicSequencer* hseq, Mid
 	sendIfChangedCC(41, (int32_t)hseq->getScaleType(), lastHarmonicScaleCC);
 	// Mode CC 42
 	sendIfChangedCC(42, (int32_t)hseq->getDistributionMode(), lastHarmonicModeCC);
-	// Steps CC 43 (1..32)
-	sendIfChangedCC(43, (int32_t)constrain((int)hseq->getSteps(),1,32), lastHarmonicStepsCC);
+	// Steps CC 43 (1..64)
+	sendIfChangedCC(43, (int32_t)constrain((int)hseq->getSteps(), 1, (int)EuclideanPatterns::MAX_STEPS), lastHarmonicStepsCC);
 	// Hits CC 44
-	sendIfChangedCC(44, (int32_t)constrain((int)hseq->getHits(),1,32), lastHarmonicHitsCC);
+	sendIfChangedCC(44, (int32_t)constrain((int)hseq->getHits(), 1, (int)EuclideanPatterns::MAX_HITS), lastHarmonicHitsCC);
 	// Offset CC 45
 	sendIfChangedCC(45, (int32_t)hseq->getOffset(), lastHarmonicOffsetCC);
 	// Poly CC 46
@@ -286,20 +283,13 @@ void MidiFeedback::enqueueRaw(uint8_t status, uint8_t data1, uint8_t data2) {
 	if (!feedbackQueue) {
 		// fallback síncrono se fila não disponível
 		if (usb_midi) {
-			usb_midi->write(status);
-			usb_midi->write(data1);
-			usb_midi->write(data2);
+			MIDIRouter::sendMessageToOutput(4, status, data1, data2);
+			MIDIRouter::flushUsbOutput();
 		}
 		// BLE removed: do not send BLE messages here
-		MIDIRouter::sendToOutput(0, status);
-		MIDIRouter::sendToOutput(0, data1);
-		MIDIRouter::sendToOutput(0, data2);
-		MIDIRouter::sendToOutput(1, status);
-		MIDIRouter::sendToOutput(1, data1);
-		MIDIRouter::sendToOutput(1, data2);
-		MIDIRouter::sendToOutput(2, status);
-		MIDIRouter::sendToOutput(2, data1);
-		MIDIRouter::sendToOutput(2, data2);
+		MIDIRouter::sendMessageToOutput(0, status, data1, data2, MidiTxScheduler::PRIO_CC);
+		MIDIRouter::sendMessageToOutput(1, status, data1, data2, MidiTxScheduler::PRIO_CC);
+		MIDIRouter::sendMessageToOutput(2, status, data1, data2, MidiTxScheduler::PRIO_CC);
 		return;
 	}
 	// tenta enfileirar sem bloquear; se cheia, descarta a mensagem
@@ -331,18 +321,18 @@ void MidiFeedback::sendAllFeedback(EuclideanSequencer* seq, MidiClock* clock) {
 	
 	// Steps (CC_STEPS = 20)
 	uint8_t steps = seq->getSteps();
-	uint8_t stepsCC = constrain(map(steps, 1, 32, 0, 127), 0, 127);
+	uint8_t stepsCC = constrain(map(steps, EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS, 0, 127), 0, 127);
 	sendCCWithProtocol(20, stepsCC, lastStepsCC);
 	
 	// Hits (CC_HITS = 21)
 	uint8_t hits = seq->getHits();
-	uint8_t hitsCC = constrain(map(hits, 1, 32, 0, 127), 0, 127);
+	uint8_t hitsCC = constrain(map(hits, EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS, 0, 127), 0, 127);
 	sendCCWithProtocol(21, hitsCC, lastHitsCC);
 	
 	// Offset (CC_OFFSET = 22) - enviar user-facing 1..N value
 	uint8_t offset = seq->getOffset();
 	uint8_t offsetUser = offset + 1; // convert internal 0..N-1 to 1..N
-	uint8_t offsetCC = map(offsetUser, 1, 32, 0, 127);
+	uint8_t offsetCC = map(offsetUser, 1, EuclideanPatterns::MAX_STEPS, 0, 127);
 	sendCCWithProtocol(22, offsetCC, lastOffsetCC);
 	
 	// Note (CC_NOTE = 23)
@@ -360,7 +350,7 @@ void MidiFeedback::sendAllFeedback(EuclideanSequencer* seq, MidiClock* clock) {
 	
 	// Track (CC_TRACK = 26)
 	uint8_t track = seq->getSelectedPattern();
-	uint8_t trackCC = map(track, 0, 7, 0, 127);
+	uint8_t trackCC = map(track, 0, EuclideanSequencer::MAX_TRACKS - 1, 0, 127);
 	sendCCWithProtocol(26, trackCC, lastTrackCC);
 
 	// Channel (CC_CHANNEL = 24)
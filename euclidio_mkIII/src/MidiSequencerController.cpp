@@ -7,18 +7,18 @@ void MidiSequencerController::processControlChange(uint8_t cc, uint8_t value, Eu
   // Converte valor MIDI (0-127) para range apropriado
   switch (cc) {
     case CC_STEPS:
-      // 0-127 mapeado para 1-32
-      seq->setSteps(constrain(map(value, 0, 127, 1, 32), 1, 32));
+      // 0-127 mapeado para 1-64 (limites de EuclideanPatterns)
+      seq->setSteps(EuclideanPatterns::clampSteps(map(value, 0, 127, EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS)));
       break;
       
     case CC_HITS:
-      // 0-127 mapeado para 1-32
-      seq->setHits(constrain(map(value, 0, 127, 1, 32), 1, 32));
+      // 0-127 mapeado para 1-64
+      seq->setHits(EuclideanPatterns::clampHits(map(value, 0, 127, EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS)));
       break;
       
     case CC_OFFSET:
-      // 0-127 mapeado para 0-31 (offset máximo é steps-1)
-      seq->setOffset(map(value, 0, 127, 0, 31));
+      // 0-127 mapeado para 0-63 (offset máximo é steps-1)
+      seq->setOffset(map(value, 0, 127, 0, EuclideanPatterns::MAX_STEPS - 1));
       break;
       
     case CC_NOTE:
@@ -36,8 +36,8 @@ void MidiSequencerController::processControlChange(uint8_t cc, uint8_t value, Eu
       break;
       
     case CC_TRACK:
-      // 0-127 mapeado para 0-7 (8 tracks)
-      seq->setSelectedPattern(map(value, 0, 127, 0, 7));
+      // 0-127 mapeado para 0..MAX_TRACKS-1
+      seq->setSelectedPattern(map(value, 0, 127, 0, EuclideanSequencer::MAX_TRACKS - 1));
       break;
       
     // CC_PLAY handling removed: Play/Stop must be triggered only via NOTE 77 (NOTE_TOGGLE_PLAY)
@@ -0,0 +1,270 @@
+#include "MidiTxScheduler.h"
+#include <freertos/FreeRTOS.h>
+
+MidiTxScheduler::MidiTxScheduler() {
+  for (uint8_t i = 0; i < NUM_PORTS; ++i) {
+    for (uint16_t h = 0; h < 256; ++h) ports[i].queuedOns[h].store(0, std::memory_order_relaxed);
+  }
+}
+
+void MidiTxScheduler::attachPort(uint8_t port, HardwareSerial* serial) {
+  if (port < NUM_PORTS) ports[port].serial = serial;
+}
+
+MidiTxScheduler::Priority MidiTxScheduler::classify(uint8_t status, uint8_t data2) {
+  if (status >= 0xF0) return PRIO_REALTIME;
+  uint8_t type = status & 0xF0;
+  if (type == 0x80 || (type == 0x90 && data2 == 0)) return PRIO_NOTE_OFF;
+  if (type == 0x90) return PRIO_NOTE_ON;
+  return PRIO_CC;
+}
+
+uint8_t MidiTxScheduler::messageLength(uint8_t status) {
+  if (status >= 0xF4) return 1;                      // tempo real, Tune Request
+  if (status == 0xF1 || status == 0xF3) return 2;    // MTC quarter frame, Song Select
+  uint8_t type = status & 0xF0;
+  if (type == 0xC0 || type == 0xD0) return 2;        // Program Change, Channel Pressure
+  return 3;
+}
+
+bool MidiTxScheduler::send(uint8_t port, Priority prio, uint8_t status, uint8_t data1, uint8_t data2) {
+  if (port >= NUM_PORTS || !ports[port].serial) return false;
+  Port& p = ports[port];
+  TxMessage m;
+  m.len = messageLength(status);
+  m.bytes[0] = status;
+  m.bytes[1] = data1;
+  m.bytes[2] = data2;
+
+  bool queued = true;
+  switch (prio) {
+    case PRIO_REALTIME:
+      // Byte único: sai já, sem esperar por quem estiver a bombear
+      if (m.len == 1 && writeRealTimeDirect(p, status)) return true;
+      queued = p.realtime.push(m);
+      if (!queued) p.stats.overflows++;
+      break;
+    case PRIO_NOTE_OFF:
+      // A nota ainda está em fila: o Note Off segue atrás dela
+      if (p.queuedOns[noteHash(m)].load() > 0) queued = pushNote(p, p.noteOns, m);
+      else queued = pushNote(p, p.noteOffs, m);
+      break;
+    case PRIO_NOTE_ON:
+      p.queuedOns[noteHash(m)]++;
+      queued = pushNote(p, p.noteOns, m);
+      if (!queued) p.queuedOns[noteHash(m)]--;
+      break;
+    case PRIO_THRU:
+      queued = p.thru.push(m);
+      if (!queued) {
+        p.stats.overflows++;
+        p.stats.dropped++;
+      }
+      break;
+    default:
+      pushCC(p, m);
+      break;
+  }
+
+  uint16_t depth = totalDepth(p);
+  if (depth > p.stats.peakDepth) p.stats.peakDepth = depth;
+  pump();
+  return queued;
+}
+
+bool MidiTxScheduler::writeRealTimeDirect(Port& p, uint8_t status) {
+  // Ainda há tempo real em fila (ex.: SPP antes do Continue): mantém a ordem.
+  // Quem bombeia só retira da fila depois de escrever, pelo que uma fila vista
+  // vazia já não tem nada por escrever à frente deste byte.
+  if (p.realtime.size() != 0) return false;
+  // Nunca bloquear no UART (a escrita de um byte é atómica no driver)
+  if (p.serial->availableForWrite() < 1) return false;
+  p.serial->write(status);
+  p.directBytes++;
+  return true;
+}
+
+bool MidiTxScheduler::pushNote(Port& p, MpscQueue<TxMessage, NOTE_QUEUE_SIZE>& q, const TxMessage& m) {
+  if (q.push(m)) return true;
+  // Fila cheia: descarta e conta (quem envia decide pelo valor devolvido)
+  p.stats.overflows++;
+  p.stats.dropped++;
+  return false;
+}
+
+void MidiTxScheduler::pushCC(Port& p, const TxMessage& m) {
+  portENTER_CRITICAL(&p.ccMux);
+  // Mesmo controlador ainda por enviar: basta atualizar o valor
+  for (uint8_t i = 0; i < p.ccCount; ++i) {
+    if (p.cc[i].bytes[0] == m.bytes[0] && p.cc[i].bytes[1] == m.bytes[1]) {
+      p.cc[i] = m;
+      p.stats.thinned++;
+      portEXIT_CRITICAL(&p.ccMux);
+      return;
+    }
+  }
+  if (p.ccCount == CC_SLOTS) {
+    // Cheia: descarta o mais antigo (o feedback mais recente é o que interessa)
+    for (uint8_t i = 1; i < CC_SLOTS; ++i) p.cc[i - 1] = p.cc[i];
+    p.ccCount--;
+    p.stats.thinned++;
+    p.stats.overflows++;
+  }
+  p.cc[p.ccCount++] = m;
+  portEXIT_CRITICAL(&p.ccMux);
+}
+
+bool MidiTxScheduler::writeMessage(Port& p, const TxMessage& m, uint32_t nowUs, uint8_t limitBytes) {
+  uint8_t status = m.bytes[0];
+  uint8_t data2 = m.bytes[2];
+  // Note Off como Note On com velocity 0: prolonga as sequências em running status
+  if (p.noteOffAsNoteOn && (status & 0xF0) == 0x80) {
+    status = 0x90 | (status & 0x0F);
+    data2 = 0;
+  }
+  // Running status: mensagem de canal com o mesmo status do anterior dispensa-o.
+  // O status é reenviado periodicamente para recetores ligados a meio.
+  bool skipStatus = p.runningStatusEnabled && status < 0xF0 && status == p.runningStatus &&
+                    (uint32_t)(nowUs - p.runningStatusSentUs) < RUNNING_STATUS_REFRESH_US;
+  uint8_t wire[3] = {status, m.bytes[1], data2};
+  const uint8_t* bytes = skipStatus ? wire + 1 : wire;
+  uint8_t len = skipStatus ? m.len - 1 : m.len;
+
+  int32_t busyUs = (int32_t)(p.busyUntilUs - nowUs);
+  if (busyUs < 0) busyUs = 0;
+  uint32_t backlog = ((uint32_t)busyUs + BYTE_US - 1) / BYTE_US;
+  if (backlog + len > limitBytes) return false;
+  // Nunca bloquear no UART
+  if (p.serial->availableForWrite() < len) return false;
+  p.serial->write(bytes, len);
+  p.busyUntilUs = nowUs + (uint32_t)busyUs + (uint32_t)len * BYTE_US;
+  p.stats.bytesSent += len;
+
+  if (status < 0xF0) {
+    if (skipStatus) {
+      p.stats.bytesSaved++;
+    } else {
+      p.runningStatus = status;
+      p.runningStatusSentUs = nowUs;
+    }
+  } else if (status < 0xF8) {
+    // System Common/SysEx cancelam o running status; tempo real é transparente
+    p.runningStatus = 0;
+  }
+  return true;
+}
+
+void MidiTxScheduler::setRunningStatus(bool enabled) {
+  for (uint8_t i = 0; i < NUM_PORTS; ++i) {
+    ports[i].runningStatusEnabled = enabled;
+    ports[i].runningStatus = 0;
+  }
+}
+
+void MidiTxScheduler::setNoteOffAsNoteOn(bool enabled) {
+  for (uint8_t i = 0; i < NUM_PORTS; ++i) ports[i].noteOffAsNoteOn = enabled;
+}
+
+void MidiTxScheduler::pumpPort(Port& p, uint32_t nowUs) {
+  if (!p.serial) return;
+  const TxMessage* m;
+  TxMessage sent;
+
+  // Bytes de tempo real já escritos diretamente: ocupam o fio à frente dos restantes
+  uint32_t direct = p.directBytes.exchange(0);
+  if (direct) {
+    if ((int32_t)(p.busyUntilUs - nowUs) < 0) p.busyUntilUs = nowUs;
+    p.busyUntilUs += direct * BYTE_US;
+    p.stats.bytesSent += direct;
+  }
+
+  // Tempo real: só limitado pelo espaço no UART
+  while ((m = p.realtime.front()) != nullptr) {
+    if (!writeMessage(p, *m, nowUs, 0xFF)) return;
+    p.realtime.pop(sent);
+  }
+
+  // Prioridade estrita: uma classe só avança com as anteriores vazias
+  while ((m = p.noteOffs.front()) != nullptr) {
+    if (!writeMessage(p, *m, nowUs, NOTE_BACKLOG_BYTES)) return;
+    p.noteOffs.pop(sent);
+  }
+
+  while ((m = p.noteOns.front()) != nullptr) {
+    if (!writeMessage(p, *m, nowUs, NOTE_BACKLOG_BYTES)) return;
+    p.noteOns.pop(sent);
+    if (classify(sent.bytes[0], sent.bytes[2]) == PRIO_NOTE_ON) p.queuedOns[noteHash(sent)]--;
+  }
+
+  while ((m = p.thru.front()) != nullptr) {
+    if (!writeMessage(p, *m, nowUs, NOTE_BACKLOG_BYTES)) return;
+    p.thru.pop(sent);
+  }
+
+  for (;;) {
+    portENTER_CRITICAL(&p.ccMux);
+    if (p.ccCount == 0) {
+      portEXIT_CRITICAL(&p.ccMux);
+      return;
+    }
+    TxMessage next = p.cc[0];
+    portEXIT_CRITICAL(&p.ccMux);
+    // Escrita fora da secção crítica; só retira se o valor não mudou entretanto
+    if (!writeMessage(p, next, nowUs, CC_BACKLOG_BYTES)) return;
+    portENTER_CRITICAL(&p.ccMux);
+    if (p.ccCount > 0 && p.cc[0].bytes[0] == next.bytes[0] && p.cc[0].bytes[1] == next.bytes[1]) {
+      if (p.cc[0].bytes[2] == next.bytes[2]) {
+        for (uint8_t i = 1; i < p.ccCount; ++i) p.cc[i - 1] = p.cc[i];
+        p.ccCount--;
+      }
+    }
+    portEXIT_CRITICAL(&p.ccMux);
+  }
+}
+
+void MidiTxScheduler::pump() {
+  pumpRequests++;
+  for (;;) {
+    // Um só consumidor de cada vez; quem está a bombear volta a ver o pedido
+    if (pumpBusy.exchange(true)) return;
+    uint32_t seen = pumpRequests.load();
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < NUM_PORTS; ++i) pumpPort(ports[i], now);
+    pumpBusy.store(false);
+    if (pumpRequests.load() == seen) return;
+  }
+}
+
+bool MidiTxScheduler::hasPending() const {
+  for (uint8_t i = 0; i < NUM_PORTS; ++i) {
+    if (totalDepth(ports[i]) > 0) return true;
+  }
+  return false;
+}
+
+uint16_t MidiTxScheduler::totalDepth(const Port& p) const {
+  return p.realtime.size() + p.noteOffs.size() + p.noteOns.size() + p.thru.size() + p.ccCount;
+}
+
+uint16_t MidiTxScheduler::getQueueDepth(uint8_t port, Priority prio) const {
+  if (port >= NUM_PORTS) return 0;
+  const Port& p = ports[port];
+  switch (prio) {
+    case PRIO_REALTIME: return p.realtime.size();
+    case PRIO_NOTE_OFF: return p.noteOffs.size();
+    case PRIO_NOTE_ON: return p.noteOns.size();
+    case PRIO_THRU: return p.thru.size();
+    default: return p.ccCount;
+  }
+}
+
+void MidiTxScheduler::resetStats() {
+  for (uint8_t i = 0; i < NUM_PORTS; ++i) {
+    ports[i].stats.bytesSent = 0;
+    ports[i].stats.overflows = 0;
+    ports[i].stats.dropped = 0;
+    ports[i].stats.thinned = 0;
+    ports[i].stats.bytesSaved = 0;
+    ports[i].stats.peakDepth = 0;
+  }
+}
@@ -32,7 +32,18 @@ const char* OSCMapping::PATH_RESOLUTION = "/sequencer/resolution";
 const char* OSCMapping::PATH_TRACK = "/sequencer/track";
 const char* OSCMapping::PATH_PLAYSTOP = "/sequencer/playstop";
 const char* OSCMapping::PATH_TEMPO = "/sequencer/tempo";
+const char* OSCMapping::PATH_TEMPO_RAMP = "/sequencer/tempo_ramp";
+const char* OSCMapping::PATH_LOCATE = "/sequencer/locate";
+const char* OSCMapping::PATH_CLOCK_RATE = "/sequencer/clock_rate";
+const char* OSCMapping::PATH_CLOCK_OFFSET = "/sequencer/clock_offset";
 const char* OSCMapping::PATH_NOTE_LENGTH = "/sequencer/note_length";
+const char* OSCMapping::PATH_GATE = "/sequencer/gate";
+const char* OSCMapping::PATH_ALGORITHM = "/sequencer/algorithm";
+const char* OSCMapping::PATH_PROBABILITY = "/sequencer/probability";
+const char* OSCMapping::PATH_RATCHET = "/sequencer/ratchet";
+const char* OSCMapping::PATH_CHANCE_STEP = "/sequencer/chance_step";
+const char* OSCMapping::PATH_RATCHET_STEP = "/sequencer/ratchet_step";
+const char* OSCMapping::PATH_SEED = "/sequencer/seed";
 // Per-track base path (clients should use "/sequencer/dub/<n>")
 const char* OSCMapping::PATH_DUB_BASE = "/sequencer/dub/";
 const char* OSCMapping::PATH_ENCODER_DOUBLE_CLICK = "/encoder/double_click";
@@ -50,6 +61,8 @@ const char* OSCMapping::PATH_HARMONIC_OFFSET = "/harmonic/offset";
 const char* OSCMapping::PATH_HARMONIC_POLY = "/harmonic/poly";
 const char* OSCMapping::PATH_HARMONIC_VELOCITY = "/harmonic/velocity";
 const char* OSCMapping::PATH_HARMONIC_NOTE_LENGTH = "/harmonic/note_length";
+const char* OSCMapping::PATH_HARMONIC_GATE = "/harmonic/gate";
+const char* OSCMapping::PATH_HARMONIC_ALGORITHM = "/harmonic/algorithm";
 const char* OSCMapping::PATH_HARMONIC_OCTAVE = "/harmonic/octave";
 const char* OSCMapping::PATH_HARMONIC_ACTIVE = "/harmonic/active";
 const char* OSCMapping::PATH_HARMONIC_TRACK = "/harmonic/track";
@@ -82,15 +95,15 @@ void OSCMapping::processMessage(const char* path, int argc, float* argv, Euclide
 	// Compara paths e processa comandos
 	if (strcmp(path, PATH_STEPS) == 0) {
 		if (argc >= 1) {
-			seq->setSteps(mapFloatToInt(argv[0], 1, 32));
+			seq->setSteps(mapFloatToInt(argv[0], EuclideanPatterns::MIN_STEPS, EuclideanPatterns::MAX_STEPS));
 		}
 	} else if (strcmp(path, PATH_HITS) == 0) {
 		if (argc >= 1) {
-			seq->setHits(mapFloatToInt(argv[0], 1, 32));
+			seq->setHits(mapFloatToInt(argv[0], EuclideanPatterns::MIN_HITS, EuclideanPatterns::MAX_HITS));
 		}
 	} else if (strcmp(path, PATH_OFFSET) == 0) {
 		if (argc >= 1) {
-			seq->setOffset(mapFloatToUint8(argv[0], 0, 31));
+			seq->setOffset(mapFloatToInt(argv[0], 0, EuclideanPatterns::MAX_STEPS - 1));
 		}
 	} else if (strcmp(path, PATH_NOTE) == 0) {
 		if (argc >= 1) {
@@ -110,7 +123,7 @@ void OSCMapping::processMessage(const char* path, int argc, float* argv, Euclide
 		}
 	} else if (strcmp(path, PATH_TRACK) == 0) {
 		if (argc >= 1) {
-			seq->setSelectedPattern(mapFloatToUint8(argv[0], 0, 7));
+			seq->setSelectedPattern((uint8_t)mapFloatToInt(argv[0], 0, EuclideanSequencer::MAX_TRACKS - 1));
 		}
 	} else if (strcmp(path, PATH_PLAYSTOP) == 0) {
 		// Mensagem combinada: /sequencer/playstop [start] [stop]
@@ -151,17 +164,76 @@ void OSCMapping::processMessage(const char* path, int argc, float* argv, Euclide
 				clock->setBPM(bpm);
 			}
 		}
+	} else if (strcmp(path, PATH_TEMPO_RAMP) == 0) {
+		// /sequencer/tempo_ramp <bpm> <beats> [shape]: shape 0 = linear, 1 = exponencial
+		if (clock && argc >= 2 && clock->isMaster()) {
+			float bpm = constrain(argv[0], 30.0f, 240.0f);
+			uint16_t beats = (uint16_t)constrain(argv[1], 0.0f, 1024.0f);
+			MidiClock::TempoRampShape shape = (argc >= 3 && argv[2] > 0) ? MidiClock::RAMP_EXPONENTIAL : MidiClock::RAMP_LINEAR;
+			clock->startTempoRamp(bpm, beats, shape);
+		}
+	} else if (strcmp(path, PATH_LOCATE) == 0) {
+		// /sequencer/locate <semicolcheias>: reposiciona e envia SPP (apenas em MASTER)
+		if (clock && argc >= 1 && clock->isMaster()) {
+			clock->locate((uint16_t)constrain(argv[0], 0.0f, 16383.0f));
+		}
+	} else if (strcmp(path, PATH_CLOCK_RATE) == 0) {
+		// /sequencer/clock_rate <saída 0..4> <taxa>: 0 = x2, 1 = x1, 2 = /2, 3 = /4
+		if (clock && argc >= 2) {
+			clock->setOutputClockRate(mapFloatToUint8(argv[0], 0, 4), (MidiClock::ClockRate)mapFloatToUint8(argv[1], 0, 3));
+		}
+	} else if (strcmp(path, PATH_CLOCK_OFFSET) == 0) {
+		// /sequencer/clock_offset <saída 0..4> <ticks>
+		if (clock && argc >= 2) {
+			clock->setOutputClockOffset(mapFloatToUint8(argv[0], 0, 4), (int8_t)mapFloatToInt(argv[1], -96, 96));
+		}
 	} else if (strcmp(path, PATH_NOTE_LENGTH) == 0) {
 		if (argc >= 1) {
 			uint16_t length = mapFloatToInt(argv[0], 50, 700);
 			seq->setNoteLength(length);
 		}
+	} else if (strcmp(path, PATH_GATE) == 0) {
+		// /sequencer/gate <modo 0=ms, 1=ticks, 2=%> [quantidade]
+		if (argc >= 1) {
+			seq->setGateMode((EuclideanSequencer::GateMode)mapFloatToUint8(argv[0], 0, EuclideanSequencer::GATE_MODE_COUNT - 1));
+			if (argc >= 2) seq->setGateAmount(mapFloatToUint8(argv[1], 1, 100));
+		}
+	} else if (strcmp(path, PATH_ALGORITHM) == 0) {
+		// /sequencer/algorithm <0=ancorado, 1=Bjorklund, 2=Bresenham>
+		if (argc >= 1) {
+			seq->setAlgorithm((EuclideanPatterns::Algorithm)mapFloatToInt(argv[0], 0, EuclideanPatterns::ALGO_COUNT - 1));
+		}
+	} else if (strcmp(path, PATH_PROBABILITY) == 0) {
+		// /sequencer/probability <0..100 %>
+		if (argc >= 1) {
+			seq->setProbability((uint8_t)mapFloatToInt(argv[0], 0, EuclideanSequencer::MAX_PROBABILITY));
+		}
+	} else if (strcmp(path, PATH_RATCHET) == 0) {
+		// /sequencer/ratchet <1..8 notas por hit>
+		if (argc >= 1) {
+			seq->setRatchet((uint8_t)mapFloatToInt(argv[0], 1, EuclideanSequencer::MAX_RATCHET));
+		}
+	} else if (strcmp(path, PATH_CHANCE_STEP) == 0) {
+		// /sequencer/chance_step <step 0..63> <0|1>: step sujeito à probabilidade
+		if (argc >= 2) {
+			seq->setStepChance((uint8_t)mapFloatToInt(argv[0], 0, EuclideanPatterns::MAX_STEPS - 1), argv[1] > 0.5f);
+		}
+	} else if (strcmp(path, PATH_RATCHET_STEP) == 0) {
+		// /sequencer/ratchet_step <step 0..63> <0|1>: step com ratchet
+		if (argc >= 2) {
+			seq->setStepRatchet((uint8_t)mapFloatToInt(argv[0], 0, EuclideanPatterns::MAX_STEPS - 1), argv[1] > 0.5f);
+		}
+	} else if (strcmp(path, PATH_SEED) == 0) {
+		// /sequencer/seed <n> (aplicada no próximo Start/SPP)
+		if (argc >= 1 && argv[0] >= 0.0f) {
+			seq->setRandomSeed((uint32_t)argv[0]);
+		}
 	} else if (strncmp(path, PATH_DUB_BASE, strlen(PATH_DUB_BASE)) == 0) {
 		// Expect path like /sequencer/dub/<n>
 		const char* suffix = path + strlen(PATH_DUB_BASE);
 		if (suffix && *suffix) {
 			int idx = atoi(suffix);
-			if (idx >= 0 && idx < 8) {
+			if (idx >= 0 && idx < EuclideanSequencer::MAX_TRACKS) {
 				uint8_t trackIdx = (uint8_t)idx;
 				bool enabled = seq->isTrackEnabled(trackIdx);
 				seq->setTrackEnabled(trackIdx, !enabled);
@@ -187,17 +259,26 @@ void OSCMapping::processMessage(const char* path, int argc, float* argv, Euclide
 		} else if (strcmp(path, PATH_HARMONIC_MODE) == 0) {
 			if (argc >= 1) harmonicSeq.setDistributionMode((EuclideanHarmonicSequencer::DistributionMode)(argv[0] >= 1.0f));
 		} else if (strcmp(path, PATH_HARMONIC_STEPS) == 0) {
-			if (argc >= 1) harmonicSeq.setSteps((uint8_t)constrain((int)argv[0], 1, 32));
+			if (argc >= 1) harmonicSeq.setSteps((uint8_t)constrain((int)argv[0], (int)EuclideanPatterns::MIN_STEPS, (int)EuclideanPatterns::MAX_STEPS));
 		} else if (strcmp(path, PATH_HARMONIC_HITS) == 0) {
-			if (argc >= 1) harmonicSeq.setHits((uint8_t)constrain((int)argv[0], 1, 32));
+			if (argc >= 1) harmonicSeq.setHits((uint8_t)constrain((int)argv[0], (int)EuclideanPatterns::MIN_HITS, (int)EuclideanPatterns::MAX_HITS));
 		} else if (strcmp(path, PATH_HARMONIC_OFFSET) == 0) {
-			if (argc >= 1) harmonicSeq.setOffset((uint8_t)constrain((int)argv[0], 0, 31));
+			if (argc >= 1) harmonicSeq.setOffset((uint8_t)constrain((int)argv[0], 0, (int)EuclideanPatterns::MAX_STEPS - 1));
 		} else if (strcmp(path, PATH_HARMONIC_POLY) == 0) {
 			if (argc >= 1) harmonicSeq.setPolyphony((uint8_t)constrain((int)argv[0], 1, 8));
 		} else if (strcmp(path, PATH_HARMONIC_VELOCITY) == 0) {
 			if (argc >= 1) harmonicSeq.setVelocity((uint8_t)constrain((int)argv[0], 0, 127));
 		} else if (strcmp(path, PATH_HARMONIC_NOTE_LENGTH) == 0) {
 			if (argc >= 1) harmonicSeq.setNoteLength((uint16_t)constrain((int)argv[0], 10, 2000));
+		} else if (strcmp(path, PATH_HARMONIC_GATE) == 0) {
+			// /harmonic/gate <mode 0=ms, 1=ticks, 2=%> [amount]
+			if (argc >= 1) {
+				harmonicSeq.setGateMode((uint8_t)constrain((int)argv[0], 0, (int)EuclideanSequencer::GATE_MODE_COUNT - 1));
+				if (argc >= 2) harmonicSeq.setGateAmount((uint8_t)constrain((int)argv[1], 1, 100));
+			}
+		} else if (strcmp(path, PATH_HARMONIC_ALGORITHM) == 0) {
+			// /harmonic/algorithm <0=anchored, 1=Bjorklund, 2=Bresenham>
+			if (argc >= 1) harmonicSeq.setAlgorithm((uint8_t)constrain((int)argv[0], 0, (int)EuclideanPatterns::ALGO_COUNT - 1));
 		} else if (strcmp(path, PATH_HARMONIC_OCTAVE) == 0) {
 			if (argc >= 1) {
 				int oct = (int)constrain((int)argv[0], -2, 2);
@@ -363,7 +444,7 @@ uint8_t OSCMapping::lastResolution = 0xFF;
 uint8_t OSCMapping::lastTrack = 0xFF;
 bool OSCMapping::lastPlayState = false;
 float OSCMapping::lastTempo = -1.0f;
-bool OSCMapping::lastDubState[8] = {false, false, false, false, false, false, false, false};
+uint64_t OSCMapping::lastDubMask = 0;
 uint16_t OSCMapping::lastNoteLength = 0xFFFF;
 
 // Harmonic caches
@@ -559,10 +640,11 @@ void OSCMapping::sendAllFeedback(EuclideanSequencer* seq, MidiClock* clock) {
 	bool dubEnabled = seq->isTrackEnabled(trackIdx);
 	if (oscEnabled) {
 		// Envia apenas quando houver mudança de estado por track (evita envio contínuo)
-		for (uint8_t i = 0; i < 8; ++i) {
+		for (uint8_t i = 0; i < EuclideanSequencer::MAX_TRACKS; ++i) {
 			bool dubEnabledTrack = seq->isTrackEnabled(i);
-			if (dubEnabledTrack != lastDubState[i]) {
-				lastDubState[i] = dubEnabledTrack;
+			const uint64_t bit = 1ULL << i;
+			if (dubEnabledTrack != ((lastDubMask & bit) != 0)) {
+				lastDubMask ^= bit;
 				char buf[32];
 				snprintf(buf, sizeof(buf), "%s%u", PATH_DUB_BASE, (unsigned)i);
 				OSCMessage msgDub(buf);
@@ -614,9 +696,10 @@ void OSCMapping::sendAllFeedbackForced(EuclideanSequencer* seq, MidiClock* clock
 	uint16_t noteLength = seq->getNoteLength(); lastNoteLength = noteLength; OSCMessage msgNoteLen(PATH_NOTE_LENGTH); msgNoteLen.add((int32_t)noteLength); if (oscEnabled) oscController->broadcastFeedback(msgNoteLen);
 
 	// Dub (per-track) - send snapshot for all tracks
-	for (uint8_t i = 0; i < 8; ++i) {
+	lastDubMask = 0;
+	for (uint8_t i = 0; i < EuclideanSequencer::MAX_TRACKS; ++i) {
 		bool dubEnabledTrack = seq->isTrackEnabled(i);
-		lastDubState[i] = dubEnabledTrack;
+		if (dubEnabledTrack) lastDubMask |= 1ULL << i;
 		if (oscEnabled) {
 			char buf[32];
 			snprintf(buf, sizeof(buf), "%s%u", PATH_DUB_BASE, (unsigned)i);
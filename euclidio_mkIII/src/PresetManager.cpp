@@ -4,6 +4,21 @@
 #include "EuclideanHarmonicSequencer.h"
 #include <SD.h>
 
+// Máscara de 64 steps <-> 16 dígitos hexadecimais (o parser de inteiros só lê int)
+static String stepMaskToHex(uint64_t mask) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%08lX%08lX", (unsigned long)(mask >> 32), (unsigned long)(mask & 0xFFFFFFFFUL));
+    return String(buf);
+}
+
+static uint64_t extractStepMask(const String& s, const String& key, uint64_t fallback) {
+    int idx = s.indexOf(key);
+    if (idx < 0) return fallback;
+    idx = s.indexOf("\"", s.indexOf(":", idx));
+    if (idx < 0) return fallback;
+    return strtoull(s.c_str() + idx + 1, nullptr, 16);
+}
+
 bool PresetManager::initDirectories() {
     if (!SdCardManager::begin()) {
         return false;
@@ -30,7 +45,7 @@ bool PresetManager::initDirectories() {
         }
     }
 
-    // Recriar sempre o preset "default" do euclidiano com 8 tracks explícitas em estado de fábrica
+    // Recriar sempre o preset "default" do euclidiano com todas as tracks (MAX_TRACKS) explícitas em estado de fábrica
     // (steps=8, hits=4, offset=0, note=36, velocity=100, midiChannel=1, resolution=2, noteLength=100, enabled=false)
     {
         String defaultEucPath = String(EUCLID_PRESETS_DIR) + "/default.json";
@@ -38,7 +53,7 @@ bool PresetManager::initDirectories() {
         json += "  \"type\": \"euclidean\",\n";
         json += "  \"version\": 1,\n";
         json += "  \"tracks\": [\n";
-        for (uint8_t t = 0; t < 8; t++) {
+        for (uint8_t t = 0; t < EuclideanSequencer::MAX_TRACKS; t++) {
             json += "    {\n";
             json += "      \"trackIndex\": " + String(t) + ",\n";
             json += "      \"steps\": 8,\n";
@@ -49,9 +64,15 @@ bool PresetManager::initDirectories() {
             json += "      \"midiChannel\": 1,\n";
             json += "      \"resolution\": 2,\n";
             json += "      \"noteLength\": 100,\n";
+            json += "      \"outputPorts\": " + String(EuclideanSequencer::PORT_ALL) + ",\n";
+            json += "      \"gateMode\": 0,\n";
+            json += "      \"gateAmount\": " + String(EuclideanSequencer::DEFAULT_GATE_AMOUNT) + ",\n";
+            json += "      \"algorithm\": 0,\n";
+            json += "      \"probability\": 100,\n";
+            json += "      \"ratchet\": 1,\n";
             json += "      \"enabled\": false\n";
             json += "    }";
-            if (t < 7) json += ",\n"; else json += "\n";
+            if (t + 1 < EuclideanSequencer::MAX_TRACKS) json += ",\n"; else json += "\n";
         }
         json += "  ]\n";
         json += "}\n";
@@ -78,8 +99,13 @@ bool PresetManager::saveEuclideanPreset(EuclideanSequencer* seq, const char* pre
     json += "  \"version\": 1,\n";
     json += "  \"tracks\": [\n";
 
-    // Guardar dados de cada track (0-7)
-    for (uint8_t t = 0; t < 8; t++) {
+    // Guardar dados de cada track ativa (0..MAX_TRACKS-1); as restantes ficam
+    // de fora e são limpas ao carregar
+    bool first = true;
+    for (uint8_t t = 0; t < EuclideanSequencer::MAX_TRACKS; t++) {
+        if (!seq->isTrackActive(t)) continue;
+        if (!first) json += ",\n";
+        first = false;
         json += "    {\n";
         json += "      \"trackIndex\": " + String(t) + ",\n";
         json += "      \"steps\": " + String(seq->getTrackSteps(t)) + ",\n";
@@ -90,17 +116,25 @@ bool PresetManager::saveEuclideanPreset(EuclideanSequencer* seq, const char* pre
         json += "      \"midiChannel\": " + String(seq->getTrackMidiChannel(t)) + ",\n";
         json += "      \"resolution\": " + String(seq->getTrackResolution(t)) + ",\n";
         json += "      \"noteLength\": " + String(seq->getTrackNoteLength(t)) + ",\n";
+        json += "      \"outputPorts\": " + String(seq->getTrackOutputPorts(t)) + ",\n";
+        json += "      \"gateMode\": " + String(seq->getTrackGateMode(t)) + ",\n";
+        json += "      \"gateAmount\": " + String(seq->getTrackGateAmount(t)) + ",\n";
+        json += "      \"algorithm\": " + String(seq->getTrackAlgorithm(t)) + ",\n";
+        json += "      \"probability\": " + String(seq->getTrackProbability(t)) + ",\n";
+        json += "      \"ratchet\": " + String(seq->getTrackRatchet(t)) + ",\n";
+        json += "      \"chanceSteps\": \"" + stepMaskToHex(seq->getTrackChanceSteps(t)) + "\",\n";
+        json += "      \"ratchetSteps\": \"" + stepMaskToHex(seq->getTrackRatchetSteps(t)) + "\",\n";
         json += "      \"enabled\": " + String(seq->isTrackEnabled(t) ? "true" : "false") + "\n";
         json += "    }";
-        if (t < 7) json += ",";
-        json += "\n";
     }
+    json += "\n";
 
     json += "  ],\n";
     json += "  \"outputNotes\": " + String(seq->getOutputNotes()) + ",\n";
     json += "  \"outputClock\": " + String(seq->getOutputClock()) + ",\n";
     json += "  \"outputMidiMap\": " + String(seq->getOutputMidiMap() ? "true" : "false") + ",\n";
-    json += "  \"outputOSCMap\": " + String(seq->getOutputOSCMap() ? "true" : "false") + "\n";
+    json += "  \"outputOSCMap\": " + String(seq->getOutputOSCMap() ? "true" : "false") + ",\n";
+    json += "  \"randomSeed\": " + String((unsigned long)seq->getRandomSeed()) + "\n";
     json += "}\n";
 
     // Guardar no SD
@@ -121,11 +155,15 @@ bool PresetManager::loadEuclideanPreset(EuclideanSequencer* seq, const char* pre
     // Parse JSON simples (sem biblioteca externa, apenas parsing manual)
     // Formato esperado: \"fieldName\": value
     
-    for (uint8_t t = 0; t < 8; t++) {
-        // Procura pelos índices das tracks no JSON
-        String trackStr = "\"trackIndex\": " + String(t);
+    for (uint8_t t = 0; t < EuclideanSequencer::MAX_TRACKS; t++) {
+        // Procura pelos índices das tracks no JSON (a vírgula evita que 1 encontre 10..19)
+        String trackStr = "\"trackIndex\": " + String(t) + ",";
         int trackIdx = json.indexOf(trackStr);
-        if (trackIdx < 0) continue;
+        if (trackIdx < 0) {
+            // Track fora do preset (inativa ou preset com menos tracks): limpa
+            seq->clearPattern(t);
+            continue;
+        }
 
         // Extrai o bloco da track (entre { e })
         int blockStart = json.lastIndexOf("{", trackIdx);
@@ -161,25 +199,52 @@ bool PresetManager::loadEuclideanPreset(EuclideanSequencer* seq, const char* pre
         int midiChannel = extractInt(blockJson, "\"midiChannel\"");
         int resolution = extractInt(blockJson, "\"resolution\"");
         int noteLength = extractInt(blockJson, "\"noteLength\"");
+        int outputPorts = extractInt(blockJson, "\"outputPorts\"");
+        int gateMode = extractInt(blockJson, "\"gateMode\"");
+        int gateAmount = extractInt(blockJson, "\"gateAmount\"");
+        int algorithm = extractInt(blockJson, "\"algorithm\"");
+        int probability = extractInt(blockJson, "\"probability\"");
+        int ratchet = extractInt(blockJson, "\"ratchet\"");
+        uint64_t chanceSteps = extractStepMask(blockJson, "\"chanceSteps\"", EuclideanSequencer::ALL_STEPS);
+        uint64_t ratchetSteps = extractStepMask(blockJson, "\"ratchetSteps\"", EuclideanSequencer::ALL_STEPS);
         bool enabled = extractBool(blockJson, "\"enabled\"");
 
         // Aplicar à track selecionada
         seq->setSelectedPattern(t);
         seq->loadPatternConfig();
         
-        if (steps > 0) seq->setSteps(steps);
-        if (hits >= 0) seq->setHits(hits);
-        if (offset >= 0) seq->setOffset(offset);
+        // Limites comuns (EuclideanPatterns) antes de truncar para uint8_t
+        if (steps > 0) seq->setSteps(EuclideanPatterns::clampSteps(steps));
+        if (hits >= 0) seq->setHits(EuclideanPatterns::clampHits(hits));
+        if (offset >= 0) seq->setOffset((uint8_t)(offset % seq->getSteps()));
+        // Presets antigos sem algoritmo: ancorado (comportamento anterior)
+        seq->setAlgorithm(EuclideanPatterns::clampAlgorithm(algorithm));
         if (note >= 0) seq->setNote(note);
         if (velocity >= 0) seq->setVelocity(velocity);
         if (midiChannel >= 0) seq->setMidiChannel(midiChannel);
         if (resolution > 0) seq->setResolution(resolution);
         if (noteLength > 0) seq->setNoteLength(noteLength);
+        // Presets antigos sem gate: ms (noteLength)
+        seq->setGateMode(gateMode >= 0 ? (EuclideanSequencer::GateMode)gateMode : EuclideanSequencer::GATE_MS);
+        if (gateAmount > 0) seq->setGateAmount(gateAmount);
+        // Presets antigos sem probabilidade/ratchet: sempre, uma nota por hit
+        seq->setProbability(probability >= 0 ? (uint8_t)constrain(probability, 0, (int)EuclideanSequencer::MAX_PROBABILITY) : EuclideanSequencer::MAX_PROBABILITY);
+        seq->setRatchet(ratchet > 0 ? (uint8_t)constrain(ratchet, 1, (int)EuclideanSequencer::MAX_RATCHET) : 1);
+        seq->setChanceSteps(chanceSteps);
+        seq->setRatchetSteps(ratchetSteps);
+        // Presets antigos sem portas: todas as portas (comportamento anterior)
+        seq->setTrackOutputPorts(t, outputPorts >= 0 ? outputPorts : EuclideanSequencer::PORT_ALL);
         seq->setTrackEnabled(t, enabled);
 
         seq->savePattern(t);
     }
 
+    // Semente das decisões aleatórias (presets antigos: a de omissão)
+    int seedIdx = json.indexOf("\"randomSeed\"");
+    uint32_t seed = EuclideanSequencer::DEFAULT_RANDOM_SEED;
+    if (seedIdx >= 0) seed = strtoul(json.c_str() + json.indexOf(":", seedIdx) + 1, nullptr, 10);
+    seq->setRandomSeed(seed);
+
     return true;
 }
 
@@ -211,6 +276,10 @@ bool PresetManager::saveHarmonicPreset(EuclideanHarmonicSequencer* seq, const ch
         json += "      \"distributionMode\": " + String(seq->getDistributionMode()) + ",\n";
         json += "      \"scaleType\": " + String(seq->getScaleType()) + ",\n";
         json += "      \"resolutionIndex\": " + String(seq->getResolutionIndex()) + ",\n";
+        json += "      \"outputPorts\": " + String(seq->getOutputPorts()) + ",\n";
+        json += "      \"gateMode\": " + String(seq->getGateMode()) + ",\n";
+        json += "      \"gateAmount\": " + String(seq->getGateAmount()) + ",\n";
+        json += "      \"algorithm\": " + String(seq->getAlgorithm()) + ",\n";
         json += "      \"enabled\": " + String(seq->isTrackEnabled(t) ? "true" : "false") + ",\n";
         
         // Salvar lista de acordes (graus da escala)
@@ -291,12 +360,19 @@ bool PresetManager::loadHarmonicPreset(EuclideanHarmonicSequencer* seq, const ch
         int distMode = extractInt(blockJson, "\"distributionMode\"");
         int scaleType = extractInt(blockJson, "\"scaleType\"");
         int resIdx = extractInt(blockJson, "\"resolutionIndex\"");
+        int outputPorts = extractInt(blockJson, "\"outputPorts\"");
+        int gateMode = extractInt(blockJson, "\"gateMode\"");
+        int gateAmount = extractInt(blockJson, "\"gateAmount\"");
+        int algorithm = extractInt(blockJson, "\"algorithm\"");
         bool enabled = extractBool(blockJson, "\"enabled\"");
 
         // Aplicar
-        if (steps > 0) seq->setSteps(steps);
-        if (hits >= 0) seq->setHits(hits);
-        if (offset >= 0) seq->setOffset(offset);
+        // Limites comuns (EuclideanPatterns) antes de truncar para uint8_t
+        if (steps > 0) seq->setSteps(EuclideanPatterns::clampSteps(steps));
+        if (hits >= 0) seq->setHits(EuclideanPatterns::clampHits(hits));
+        if (offset >= 0) seq->setOffset((uint8_t)(offset % seq->getSteps()));
+        // Presets antigos sem algoritmo: ancorado (comportamento anterior)
+        seq->setAlgorithm(EuclideanPatterns::clampAlgorithm(algorithm));
         if (tonic >= 0) seq->setTonic(tonic);
         if (baseOctave >= -2 && baseOctave <= 2) seq->setBaseOctave(baseOctave);
         if (polyphony > 0) seq->setPolyphony(polyphony);
@@ -306,6 +382,9 @@ bool PresetManager::loadHarmonicPreset(EuclideanHarmonicSequencer* seq, const ch
         if (distMode >= 0) seq->setDistributionMode(distMode);
         if (scaleType >= 0) seq->setScaleType((EuclideanHarmonicSequencer::ScaleType)scaleType);
         if (resIdx >= 0) seq->setResolutionIndex(resIdx);
+        seq->setOutputPorts(outputPorts >= 0 ? outputPorts : EuclideanSequencer::PORT_ALL);
+        seq->setGateMode(gateMode >= 0 ? gateMode : EuclideanSequencer::GATE_MS);
+        if (gateAmount > 0) seq->setGateAmount(gateAmount);
     }
 
     return true;
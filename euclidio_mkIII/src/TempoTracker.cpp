@@ -0,0 +1,103 @@
+#include "TempoTracker.h"
+
+TempoTracker::TempoTracker() {
+  reset();
+}
+
+void TempoTracker::reset() {
+  periodUs = 0.0f;
+  lastClockUs = 0;
+  hasLast = false;
+  locked = false;
+  consistentCount = 0;
+  anomalyScore = 0;
+  missingClocks = 0;
+  doubledClocks = 0;
+}
+
+uint8_t TempoTracker::onClock(uint32_t nowUs) {
+  if (!hasLast) {
+    hasLast = true;
+    lastClockUs = nowUs;
+    return 1;
+  }
+
+  float interval = (float)(uint32_t)(nowUs - lastClockUs);
+
+  // Ainda sem estimativa: aceita o primeiro intervalo tal como chega
+  if (periodUs <= 0.0f) {
+    periodUs = interval;
+    lastClockUs = nowUs;
+    return 1;
+  }
+
+  float ratio = interval / periodUs;
+
+  // Clock duplicado (ou glitch): não conta nem mexe na estimativa
+  if (locked && ratio < 0.5f) {
+    doubledClocks++;
+    if (registerAnomaly()) {
+      lastClockUs = nowUs;
+      return 1;
+    }
+    return 0;
+  }
+
+  lastClockUs = nowUs;
+
+  // Buraco demasiado grande: a fonte parou e voltou, recomeça aquisição
+  if (locked && ratio > MAX_MISSING_CLOCKS + 1.5f) {
+    locked = false;
+    consistentCount = 0;
+    return 1;
+  }
+
+  uint8_t ticks = 1;
+  if (locked) {
+    ticks = (uint8_t)(ratio + 0.5f);
+    if (ticks < 1) ticks = 1;
+    if (ticks > 1) {
+      missingClocks += ticks - 1;
+      if (registerAnomaly()) return 1;
+    } else if (anomalyScore > 0) {
+      anomalyScore--;
+    }
+  }
+
+  float measured = interval / ticks;
+  float deviation = (measured - periodUs) / periodUs;
+  if (deviation < 0) deviation = -deviation;
+
+  if (!locked) {
+    // Aquisição: segue rapidamente o tempo até haver intervalos consistentes
+    if (deviation < LOCK_TOLERANCE) {
+      periodUs += 0.5f * (measured - periodUs);
+      if (++consistentCount >= LOCK_CLOCKS) locked = true;
+    } else {
+      periodUs = measured;
+      consistentCount = 0;
+    }
+  } else {
+    periodUs += ALPHA * (measured - periodUs);
+  }
+
+  return ticks;
+}
+
+bool TempoTracker::registerAnomaly() {
+  // Anomalias isoladas são jitter/glitches; se persistirem, o tempo da fonte
+  // mudou de forma brusca e a estimativa atual deixou de ser válida.
+  anomalyScore += 2;
+  if (anomalyScore < ANOMALY_UNLOCK_SCORE) return false;
+  locked = false;
+  consistentCount = 0;
+  anomalyScore = 0;
+  return true;
+}
+
+float TempoTracker::correctedPeriodUs(float phaseErrorTicks) {
+  float correction = KP * phaseErrorTicks;
+  if (correction > MAX_CORRECTION) correction = MAX_CORRECTION;
+  if (correction < -MAX_CORRECTION) correction = -MAX_CORRECTION;
+  return periodUs * (1.0f - correction);
+}
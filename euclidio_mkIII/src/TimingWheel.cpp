@@ -0,0 +1,104 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel() {
+  reset(0);
+}
+
+void TimingWheel::reset(uint32_t nowUs) {
+  for (uint16_t i = 0; i < SLOTS; ++i) {
+    level0[i] = NIL;
+    level1[i] = NIL;
+  }
+  // Lista livre encadeada pelo próprio pool
+  for (uint16_t i = 0; i < MAX_EVENTS; ++i) {
+    nodes[i].next = (i + 1 < MAX_EVENTS) ? (uint16_t)(i + 1) : NIL;
+  }
+  freeHead = 0;
+  count = 0;
+  peakCount = 0;
+  currentTick = 0;
+  tickStartUs = nowUs;
+  droppedEvents = 0;
+}
+
+bool TimingWheel::schedule(uint32_t nowUs, uint32_t delayUs, uint32_t payload) {
+  if (freeHead == NIL) {
+    droppedEvents++;
+    return false;
+  }
+  uint16_t idx = freeHead;
+  freeHead = nodes[idx].next;
+
+  // Distância em ticks a partir do início do tick atual, arredondada para cima
+  // (um Note Off nunca sai antes do prazo); no mínimo o próximo tick (o slot
+  // do tick atual já foi processado)
+  uint32_t ticks = ((nowUs - tickStartUs) + delayUs + TICK_US - 1) / TICK_US;
+  if (ticks == 0) ticks = 1;
+  const uint32_t maxTicks = (uint32_t)SLOTS * (SLOTS - 1);
+  if (ticks > maxTicks) ticks = maxTicks;
+
+  nodes[idx].expiry = currentTick + ticks;
+  nodes[idx].payload = payload;
+  insertNode(idx);
+
+  if (++count > peakCount) peakCount = count;
+  return true;
+}
+
+void TimingWheel::insertNode(uint16_t idx) {
+  uint32_t delta = nodes[idx].expiry - currentTick;
+  uint16_t* slot;
+  if (delta < SLOTS) {
+    slot = &level0[nodes[idx].expiry & (SLOTS - 1)];
+  } else {
+    slot = &level1[(nodes[idx].expiry >> 8) & (SLOTS - 1)];
+  }
+  nodes[idx].next = *slot;
+  *slot = idx;
+}
+
+void TimingWheel::cascade() {
+  uint16_t* slot = &level1[(currentTick >> 8) & (SLOTS - 1)];
+  uint16_t idx = *slot;
+  *slot = NIL;
+  while (idx != NIL) {
+    uint16_t next = nodes[idx].next;
+    insertNode(idx);
+    idx = next;
+  }
+}
+
+uint16_t TimingWheel::drainCurrentSlot(uint32_t* out, uint16_t maxOut) {
+  uint16_t* slot = &level0[currentTick & (SLOTS - 1)];
+  uint16_t n = 0;
+  while (*slot != NIL && n < maxOut) {
+    uint16_t idx = *slot;
+    *slot = nodes[idx].next;
+    out[n++] = nodes[idx].payload;
+    nodes[idx].next = freeHead;
+    freeHead = idx;
+    count--;
+  }
+  return n;
+}
+
+uint16_t TimingWheel::advance(uint32_t nowUs, uint32_t* out, uint16_t maxOut) {
+  // Restos do tick atual (se `out` encheu na chamada anterior)
+  uint16_t n = drainCurrentSlot(out, maxOut);
+
+  while ((uint32_t)(nowUs - tickStartUs) >= TICK_US) {
+    if (count == 0) {
+      // Roda vazia: salta diretamente para o tick atual
+      uint32_t ticks = (nowUs - tickStartUs) / TICK_US;
+      currentTick += ticks;
+      tickStartUs += ticks * TICK_US;
+      break;
+    }
+    if (n >= maxOut) break;
+    tickStartUs += TICK_US;
+    currentTick++;
+    if ((currentTick & (SLOTS - 1)) == 0) cascade();
+    n += drainCurrentSlot(out + n, maxOut - n);
+  }
+  return n;
+}
@@ -422,9 +422,9 @@ void UIController::drawEuclideanCircle(EuclideanSequencer &seq, MidiClock &clock
   // Não desenhar o círculo central
 
   // Pontos para todos os steps/hits de todas as tracks
-  for (uint8_t t = 0; t < 8; ++t) {
-    // Skip tracks that are not active or explicitly disabled (dub off)
-    if (!seq.isTrackActive(t) || !seq.isTrackEnabled(t)) continue;
+  // Apenas tracks ativas e ligadas (dub on): percorre os bits da máscara
+  for (EuclideanSequencer::TrackMask m = seq.getPlayingTracks(); m; m &= m - 1) {
+    uint8_t t = EuclideanSequencer::lowestTrack(m);
     uint8_t tSteps = seq.getTrackSteps(t);
     if (tSteps == 0) continue;
     for (uint8_t i = 0; i < tSteps; i++) {
@@ -489,8 +489,8 @@ void UIController::drawEuclideanCircle(EuclideanSequencer &seq, MidiClock &clock
 
   // Ponteiros/agulho: uma linha por track
   if (seq.isRunningState()) {
-    for (uint8_t t = 0; t < 8; ++t) {
-      if (!seq.isTrackActive(t) || !seq.isTrackEnabled(t)) continue;
+    for (EuclideanSequencer::TrackMask m = seq.getPlayingTracks(); m; m &= m - 1) {
+      uint8_t t = EuclideanSequencer::lowestTrack(m);
       uint8_t tSteps = seq.getTrackSteps(t);
       if (tSteps == 0) continue;
       // Corrige visualização: agulha começa no passo 0 (vertical/12h)
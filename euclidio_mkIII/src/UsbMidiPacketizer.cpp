@@ -0,0 +1,153 @@
+#include "UsbMidiPacketizer.h"
+#include <Adafruit_TinyUSB.h>
+#include <string.h>
+
+uint8_t UsbMidiPacketizer::codeIndex(uint8_t status) {
+  if (status >= 0xF8) return 0x0F;                   // tempo real: byte único
+  if (status >= 0xF0) {
+    if (status == 0xF2) return 0x03;                 // System Common de 3 bytes (SPP)
+    if (status == 0xF1 || status == 0xF3) return 0x02;
+    return 0x05;                                     // System Common de 1 byte (0xF6)
+  }
+  return status >> 4;                                // mensagens de canal: 0x8..0xE
+}
+
+void UsbMidiPacketizer::write(uint8_t status, uint8_t data1, uint8_t data2) {
+  if (!usb_midi) return;
+  uint8_t type = status & 0xF0;
+  bool system = status >= 0xF0;
+  // CC, Note On e restantes mensagens de canal deixam a reserva para os Note Off
+  bool reserved = system || type == 0x80 || (type == 0x90 && data2 == 0);
+  uint8_t limit = reserved ? BUFFER_PACKETS : (uint8_t)(BUFFER_PACKETS - NOTE_OFF_RESERVE);
+  bool full = false;
+  for (uint8_t attempt = 0; attempt < 2; ++attempt) {
+    portENTER_CRITICAL(&mux);
+    // Segunda tentativa ainda cheia: um Note Off ou sistema tira o lugar ao
+    // CC/Note On mais antigo
+    if (count >= limit && reserved && attempt == 1 && evictDroppable(packets, count)) {
+      stats.droppedPackets++;
+    }
+    if (count < limit) {
+      uint8_t* p = packets[count];
+      uint8_t cin = codeIndex(status);
+      p[0] = (CABLE << 4) | cin;
+      p[1] = status;
+      // Bytes não usados pela mensagem vão a 0 (USB-MIDI 1.0)
+      p[2] = (cin == 0x0F || cin == 0x05) ? 0 : data1;
+      p[3] = (cin == 0x0F || cin == 0x05 || cin == 0x02 || cin == 0x0C || cin == 0x0D) ? 0 : data2;
+      if (count == 0) firstPacketUs = micros();
+      count++;
+      if (system) systemPending++;
+      full = (count >= FLUSH_PACKETS);
+      portEXIT_CRITICAL(&mux);
+      if (full) flush();
+      return;
+    }
+    portEXIT_CRITICAL(&mux);
+    // Buffer cheio: esvazia e tenta outra vez
+    flush();
+  }
+  stats.droppedPackets++;
+}
+
+void UsbMidiPacketizer::writeRealTime(uint8_t status) {
+  if (!usb_midi) return;
+  // Quem esvazia só desconta uma mensagem de sistema depois de a entregar:
+  // com zero pendentes não há nada por escrever que tenha de sair antes deste byte
+  if (systemPending.load() == 0) {
+    // Um pacote isolado é escrito de uma vez no FIFO do TinyUSB, entre dois
+    // pacotes de quem estiver a esvaziar
+    uint8_t p[4] = {(uint8_t)((CABLE << 4) | 0x0F), status, 0, 0};
+    if (usb_midi->writePacket(p)) {
+      stats.realtimeDirect++;
+      return;
+    }
+  }
+  write(status);
+  flush();
+}
+
+void UsbMidiPacketizer::flush() {
+  if (!usb_midi) return;
+  flushRequests++;
+  for (;;) {
+    // Um só esvaziador de cada vez; quem está a esvaziar volta a ver o pedido
+    if (flushBusy.exchange(true)) return;
+    uint32_t seen = flushRequests.load();
+
+    uint8_t batch[BUFFER_PACKETS][4];
+    portENTER_CRITICAL(&mux);
+    uint8_t n = count;
+    uint32_t firstUs = firstPacketUs;
+    memcpy(batch, packets, (size_t)n * 4);
+    count = 0;
+    portEXIT_CRITICAL(&mux);
+
+    uint8_t sent = 0;
+    while (sent < n && usb_midi->writePacket(batch[sent])) {
+      if (batch[sent][1] >= 0xF0) systemPending--;
+      sent++;
+    }
+    // FIFO do TinyUSB cheio: o resto volta ao buffer para o próximo flush
+    bool stalled = sent < n;
+    if (stalled) requeue(batch + sent, n - sent, firstUs);
+    if (sent > 0) {
+      uint32_t latency = micros() - firstUs;
+      stats.flushes++;
+      stats.packets += sent;
+      if (sent > stats.maxPacketsPerFlush) stats.maxPacketsPerFlush = sent;
+      stats.lastFlushLatencyUs = latency;
+      if (latency > stats.maxFlushLatencyUs) stats.maxFlushLatencyUs = latency;
+    }
+
+    flushBusy.store(false);
+    // Com o host sem ler não vale a pena repetir já
+    if (stalled || flushRequests.load() == seen) return;
+  }
+}
+
+bool UsbMidiPacketizer::evictDroppable(uint8_t (*buf)[4], uint8_t& n) {
+  // Primeiro o CC (ou outra mensagem de canal) mais antigo, depois o Note On mais antigo
+  for (uint8_t pass = 0; pass < 2; ++pass) {
+    for (uint8_t i = 0; i < n; ++i) {
+      if (buf[i][1] >= 0xF0 || isNoteOffPacket(buf[i])) continue;
+      if (pass == 0 && (buf[i][0] & 0x0F) == 0x09) continue;
+      memmove(buf + i, buf + i + 1, (size_t)(n - i - 1) * 4);
+      n--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void UsbMidiPacketizer::requeue(const uint8_t (*batch)[4], uint8_t n, uint32_t firstUs) {
+  uint8_t merged[2 * BUFFER_PACKETS][4];
+  portENTER_CRITICAL(&mux);
+  // Pacotes acumulados entretanto ficam atrás dos que não saíram
+  memcpy(merged, batch, (size_t)n * 4);
+  memcpy(merged + n, packets, (size_t)count * 4);
+  uint8_t total = (uint8_t)(n + count);
+  // Sem espaço para todos: descarta primeiro CC e Note On; só depois o mais antigo
+  while (total > BUFFER_PACKETS) {
+    if (!evictDroppable(merged, total)) {
+      if (merged[0][1] >= 0xF0) systemPending--;
+      memmove(merged, merged + 1, (size_t)(total - 1) * 4);
+      total--;
+    }
+    stats.droppedPackets++;
+  }
+  memcpy(packets, merged, (size_t)total * 4);
+  count = total;
+  firstPacketUs = firstUs;
+  portEXIT_CRITICAL(&mux);
+}
+
+void UsbMidiPacketizer::resetStats() {
+  stats.flushes = 0;
+  stats.packets = 0;
+  stats.maxPacketsPerFlush = 0;
+  stats.lastFlushLatencyUs = 0;
+  stats.maxFlushLatencyUs = 0;
+  stats.droppedPackets = 0;
+  stats.realtimeDirect = 0;
+}
@@ -135,8 +135,12 @@ void initSequencer() {
 	
 	// Register MidiClock callbacks to route Start/Stop/Clock to selected outputs
 	midiClock.setClockCallback(MIDIRouter::clockTickCallback);
+	midiClock.setClockPulseCallback(MIDIRouter::clockPulseCallback);
 	midiClock.setStartCallback(MIDIRouter::startCallback);
 	midiClock.setStopCallback(MIDIRouter::stopCallback);
+	midiClock.setContinueCallback(MIDIRouter::continueCallback);
+	midiClock.setLocateCallback(MIDIRouter::locateCallback);
+	midiClock.setScheduledEventCallback(MIDIRouter::scheduledEventCallback);
 
 	// Network (OSC over WiFi)
 	oscController.setEuclideanSequencer(&euclSeq);
@@ -264,6 +268,11 @@ void handleUsbMidi() {
 		if (!usb_midi.available()) break;
 		uint8_t data2 = usb_midi.read();
 		
+		if (status == 0xF2) {
+			MIDIRouter::routeSongPosition(4, data1, data2);
+			continue;
+		}
+		
 		MIDIRouter::routeChannelMessage(4, status, data1, data2);
 	}
 }
@@ -409,9 +418,7 @@ void setup() {
     PresetManager::initDirectories();
 }
 void loop() {
-	// Prioridade 1: Processar engine MIDI (notas, timing crítico)
-	euclidMidiEngine.update();
-	// Processar envios pendentes gerados pelo ISR do MidiClock (envio seguro de Start/Stop/Clock)
+	// Prioridade 1: Processar envios pendentes gerados pelo ISR do MidiClock (envio seguro de Start/Stop/Clock)
 	// If a dedicated clock task exists, it will process pending realtime events.
 	// Otherwise, process them here in the main loop for compatibility.
 	if (!midiClock.clockTaskHandle) {
@@ -430,6 +437,8 @@ void loop() {
 	// (snapshots e updates específicos já existentes em MidiFeedback/OSCMapping).
 	// Prioridade 3: Input (interrupções já ligadas, só processar)
 	handleAllMidiInput();
+	// Thru para USB desta volta num só lote de pacotes
+	MIDIRouter::flushUsbOutput();
 	// Process deferred OSC-initiated encoder double-clicks in main context
 	if (oscEncoderDoubleClickRequested) {
 		oscEncoderDoubleClickRequested = false;
@@ -0,0 +1,73 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Substituto mínimo do Arduino-ESP32 para os testes no host (env:native).
+// O tempo é simulado: micros() só avança com hostsim::advanceTo(), que
+// dispara o alarme do timer (e o respetivo ISR) nos instantes exatos.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Timer de hardware com auto-reload: o contador volta a 0 em cada alarme
+struct hw_timer_t {
+  void (*isr)();
+  uint64_t alarmUs;
+  uint32_t baseUs;     // micros() em que o contador esteve a 0
+  bool enabled;
+};
+
+namespace hostsim {
+
+inline uint32_t& nowUs() {
+  static uint32_t now = 0;
+  return now;
+}
+
+inline hw_timer_t& timer() {
+  static hw_timer_t t = {nullptr, 0, 0, false};
+  return t;
+}
+
+// Avança o tempo até `targetUs`, disparando o ISR em cada alarme pelo caminho
+inline void advanceTo(uint32_t targetUs) {
+  hw_timer_t& t = timer();
+  while (t.enabled && t.isr && t.alarmUs > 0 &&
+         (int32_t)(targetUs - (t.baseUs + (uint32_t)t.alarmUs)) >= 0) {
+    nowUs() = t.baseUs + (uint32_t)t.alarmUs;
+    t.baseUs = nowUs();
+    t.isr();
+  }
+  nowUs() = targetUs;
+}
+
+// Instante do próximo alarme (ou `nowUs()` se o timer estiver parado)
+inline uint32_t nextAlarmUs() {
+  const hw_timer_t& t = timer();
+  return (t.enabled && t.alarmUs > 0) ? t.baseUs + (uint32_t)t.alarmUs : nowUs();
+}
+
+inline void reset() {
+  nowUs() = 0;
+  timer() = hw_timer_t{nullptr, 0, 0, false};
+}
+
+} // namespace hostsim
+
+inline unsigned long micros() { return hostsim::nowUs(); }
+inline unsigned long millis() { return hostsim::nowUs() / 1000; }
+
+inline hw_timer_t* timerBegin(uint8_t, uint16_t, bool) { return &hostsim::timer(); }
+inline void timerAttachInterrupt(hw_timer_t* t, void (*isr)(), bool) { t->isr = isr; }
+inline void timerAlarmWrite(hw_timer_t* t, uint64_t alarmUs, bool) { t->alarmUs = alarmUs; }
+inline void timerAlarmEnable(hw_timer_t* t) { t->enabled = true; }
+inline void timerAlarmDisable(hw_timer_t* t) { t->enabled = false; }
+inline void timerWrite(hw_timer_t* t, uint64_t value) { t->baseUs = hostsim::nowUs() - (uint32_t)value; }
+inline uint64_t timerRead(hw_timer_t* t) { return hostsim::nowUs() - t->baseUs; }
+
+#endif // HOST_ARDUINO_H
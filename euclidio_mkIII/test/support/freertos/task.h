@@ -0,0 +1,17 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+// Sem scheduler: o teste chama diretamente o que a task faria
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*,
+                                          UBaseType_t, TaskHandle_t* handle, int) {
+  if (handle) *handle = nullptr;
+  return pdPASS;
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t*) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,247 @@
+// Microbenchmark no host da avaliação de steps por tick: o render de todas
+// as tracks tal como era antes das máscaras (regra (i*hits)%steps com rotação
+// e limites a cada chamada, seis getters por track em todos os ticks) contra
+// o render atual (bit da track em getPlayingTracks(), saída cedo sem
+// fronteira de step, shift sobre a máscara). As duas versões correm sobre o
+// EuclideanSequencer real e têm de produzir exatamente as mesmas notas.
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include "EuclideanSequencer.h"
+
+static const uint8_t TRACKS = EuclideanSequencer::MAX_TRACKS;
+static const uint8_t RENDER_SLOTS = 16;
+static const uint8_t ticksPerResolution[4] = {24, 12, 6, 3};   // como EuclideanMidiEngine
+
+static EuclideanSequencer seq;
+
+struct RenderedNote {
+  uint32_t tick;
+  uint8_t channel, note, velocity, ports, gateMode, gateAmount, stepTicks;
+  uint16_t lengthMs;
+};
+
+struct TrackRender {
+  RenderedNote events[RENDER_SLOTS];
+  uint8_t head, tail;
+  uint32_t renderedUpTo;
+};
+
+static TrackRender renders[TRACKS];
+
+// Avaliação antiga de EuclideanSequencer::getTrackPatternBit (recalculada em cada chamada)
+static bool legacyPatternBit(uint8_t trackIdx, uint8_t step) {
+  if (trackIdx < TRACKS && seq.isTrackActive(trackIdx)) {
+    if (step < seq.getTrackSteps(trackIdx)) {
+      uint8_t steps = seq.getTrackSteps(trackIdx);
+      uint8_t hits = seq.getTrackHits(trackIdx);
+      if (hits > steps) hits = steps;
+      if (steps == 0 || hits == 0) return false;
+      if (hits == steps) return true;
+      uint8_t src = step;
+      uint8_t offset = seq.getTrackOffset(trackIdx);
+      if (offset % steps != 0) {
+        uint8_t off = offset % steps;
+        src = (step + steps - off) % steps;
+      }
+      return ((((uint16_t)src * hits) % steps) < hits);
+    }
+  }
+  return false;
+}
+
+static void storeNote(TrackRender& r, uint32_t tick, uint8_t channel, uint8_t note, uint8_t velocity,
+                      uint16_t lengthMs, uint8_t ports, uint8_t gateMode, uint8_t gateAmount, uint16_t stepTicks) {
+  RenderedNote& n = r.events[r.head & (RENDER_SLOTS - 1)];
+  n.tick = tick;
+  n.channel = channel;
+  n.note = note;
+  n.velocity = velocity;
+  n.lengthMs = lengthMs;
+  n.ports = ports;
+  n.gateMode = gateMode;
+  n.gateAmount = gateAmount;
+  n.stepTicks = (uint8_t)stepTicks;
+  r.head++;
+}
+
+// EuclideanMidiEngine::renderTrack antes das máscaras
+static void renderTrackLegacy(uint8_t trackIdx, uint32_t untilTick) {
+  TrackRender& r = renders[trackIdx];
+  if (r.renderedUpTo > untilTick) return;
+  if (!(seq.isTrackActive(trackIdx) && seq.isTrackEnabled(trackIdx))) {
+    r.renderedUpTo = untilTick + 1;
+    return;
+  }
+
+  uint16_t trackTicksPerStep = ticksPerResolution[seq.getTrackResolution(trackIdx) - 1];
+  uint8_t trackSteps = seq.getTrackSteps(trackIdx);
+  if (trackSteps == 0) trackSteps = 1;
+  uint8_t note = seq.getTrackNote(trackIdx);
+  uint8_t velocity = seq.getTrackVelocity(trackIdx);
+  uint8_t channel = seq.getTrackMidiChannel(trackIdx);
+  uint16_t lengthMs = seq.getTrackNoteLength(trackIdx);
+  uint8_t ports = seq.getTrackOutputPorts(trackIdx);
+  uint8_t gateMode = seq.getTrackGateMode(trackIdx);
+  uint8_t gateAmount = seq.getTrackGateAmount(trackIdx);
+  if (ports == 0) {
+    r.renderedUpTo = untilTick + 1;
+    return;
+  }
+
+  uint32_t tick = ((r.renderedUpTo + trackTicksPerStep - 1) / trackTicksPerStep) * trackTicksPerStep;
+  for (; tick <= untilTick; tick += trackTicksPerStep) {
+    uint8_t trackEuclStep = (tick / trackTicksPerStep) % trackSteps;
+    if (!legacyPatternBit(trackIdx, trackEuclStep)) continue;
+    if ((uint8_t)(r.head - r.tail) >= RENDER_SLOTS) {
+      r.renderedUpTo = tick;
+      return;
+    }
+    storeNote(r, tick, channel, note, velocity, lengthMs, ports, gateMode, gateAmount, trackTicksPerStep);
+  }
+  r.renderedUpTo = untilTick + 1;
+}
+
+// EuclideanMidiEngine::renderTrack com máscaras (sem probabilidade/ratchet,
+// para comparar apenas a avaliação dos steps)
+static void renderTrackMask(uint8_t trackIdx, uint32_t untilTick) {
+  TrackRender& r = renders[trackIdx];
+  if (r.renderedUpTo > untilTick) return;
+  uint64_t mask = seq.getTrackPatternMask(trackIdx);
+  if (!(seq.getPlayingTracks() & EuclideanSequencer::trackBit(trackIdx)) || mask == 0) {
+    r.renderedUpTo = untilTick + 1;
+    return;
+  }
+
+  uint16_t trackTicksPerStep = ticksPerResolution[seq.getTrackResolution(trackIdx) - 1];
+  uint32_t tick = ((r.renderedUpTo + trackTicksPerStep - 1) / trackTicksPerStep) * trackTicksPerStep;
+  if (tick > untilTick) {
+    r.renderedUpTo = untilTick + 1;
+    return;
+  }
+  uint8_t trackSteps = seq.getTrackSteps(trackIdx);
+  if (trackSteps == 0) trackSteps = 1;
+  uint8_t note = seq.getTrackNote(trackIdx);
+  uint8_t velocity = seq.getTrackVelocity(trackIdx);
+  uint8_t channel = seq.getTrackMidiChannel(trackIdx);
+  uint16_t lengthMs = seq.getTrackNoteLength(trackIdx);
+  uint8_t ports = seq.getTrackOutputPorts(trackIdx);
+  uint8_t gateMode = seq.getTrackGateMode(trackIdx);
+  uint8_t gateAmount = seq.getTrackGateAmount(trackIdx);
+  if (ports == 0) {
+    r.renderedUpTo = untilTick + 1;
+    return;
+  }
+
+  uint8_t trackEuclStep = (tick / trackTicksPerStep) % trackSteps;
+  for (; tick <= untilTick; tick += trackTicksPerStep) {
+    uint8_t step = trackEuclStep;
+    if (++trackEuclStep >= trackSteps) trackEuclStep = 0;
+    if (!((mask >> step) & 1)) continue;
+    if ((uint8_t)(r.head - r.tail) >= RENDER_SLOTS) {
+      r.renderedUpTo = tick;
+      return;
+    }
+    storeNote(r, tick, channel, note, velocity, lengthMs, ports, gateMode, gateAmount, trackTicksPerStep);
+  }
+  r.renderedUpTo = untilTick + 1;
+}
+
+struct RunResult {
+  uint32_t notes;
+  uint64_t hash;
+  double nsPerTick;
+};
+
+// Corre `ticks` ticks (janela de um tick, como o onClockTick) e consome as notas
+static RunResult runRender(void (*render)(uint8_t, uint32_t), uint32_t ticks) {
+  typedef std::chrono::steady_clock Clock;
+  for (uint8_t t = 0; t < TRACKS; ++t) renders[t] = TrackRender();
+  RunResult res = {0, 1469598103934665603ULL, 0.0};
+  Clock::time_point start = Clock::now();
+  for (uint32_t tick = 0; tick < ticks; ++tick) {
+    for (uint8_t t = 0; t < TRACKS; ++t) render(t, tick);
+    for (uint8_t t = 0; t < TRACKS; ++t) {
+      TrackRender& r = renders[t];
+      while (r.tail != r.head) {
+        const RenderedNote& n = r.events[r.tail & (RENDER_SLOTS - 1)];
+        res.hash = (res.hash ^ ((uint64_t)n.tick << 8 | t)) * 1099511628211ULL;
+        res.notes++;
+        r.tail++;
+      }
+    }
+  }
+  res.nsPerTick = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ticks;
+  return res;
+}
+
+// Melhor de várias corridas (menos ruído do sistema operativo)
+static RunResult bestOf(void (*render)(uint8_t, uint32_t), uint32_t ticks, uint8_t runs) {
+  RunResult best = runRender(render, ticks);
+  for (uint8_t i = 1; i < runs; ++i) {
+    RunResult r = runRender(render, ticks);
+    if (r.nsPerTick < best.nsPerTick) best.nsPerTick = r.nsPerTick;
+  }
+  return best;
+}
+
+static void configureTrack(uint8_t t, uint8_t steps, uint8_t hits, uint8_t offset, uint8_t resolution, bool enabled) {
+  seq.setSelectedPattern(t);
+  seq.setSteps(steps);
+  seq.setHits(hits);
+  seq.setOffset(offset);
+  seq.setResolution(resolution);
+  seq.setTrackEnabled(t, enabled);
+}
+
+static void compare(const char* name) {
+  const uint32_t ticks = 96 * 1000;
+  RunResult before = bestOf(renderTrackLegacy, ticks, 5);
+  RunResult after = bestOf(renderTrackMask, ticks, 5);
+
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%s: %u notas em %u ticks, antes %.1f ns/tick, depois %.1f ns/tick (%.2fx)",
+           name, (unsigned)after.notes, (unsigned)ticks, before.nsPerTick, after.nsPerTick,
+           before.nsPerTick / after.nsPerTick);
+  TEST_MESSAGE(line);
+
+  // Mesmas notas nos mesmos ticks, e a versão com máscaras não pode ser mais lenta
+  TEST_ASSERT_EQUAL_UINT32(before.notes, after.notes);
+  TEST_ASSERT_TRUE_MESSAGE(before.hash == after.hash, "notas diferentes entre as duas versões");
+  TEST_ASSERT_TRUE(after.notes > 0);
+  TEST_ASSERT_TRUE_MESSAGE(after.nsPerTick < before.nsPerTick, "render com máscaras mais lento");
+}
+
+void setUp() {
+  seq = EuclideanSequencer();
+  seq.begin();
+}
+
+void tearDown() {}
+
+void test_all_tracks_16_steps_sixteenths() {
+  for (uint8_t t = 0; t < TRACKS; ++t) configureTrack(t, 16, (uint8_t)(3 + t % 9), (uint8_t)(t % 5), 3, true);
+  compare("todas as tracks, 16 steps a 1/16");
+}
+
+void test_mixed_lengths_and_resolutions() {
+  for (uint8_t t = 0; t < TRACKS; ++t) {
+    uint8_t steps = (uint8_t)(5 + (t * 7) % 60);
+    configureTrack(t, steps, (uint8_t)(1 + (t * 5) % steps), (uint8_t)(t * 3), (uint8_t)(1 + t % 4), true);
+  }
+  compare("steps 5..64, resoluções 1/4..1/32");
+}
+
+void test_half_the_tracks_muted() {
+  for (uint8_t t = 0; t < TRACKS; ++t) configureTrack(t, 16, 5, 0, 4, (t & 1) == 0);
+  compare("metade das tracks desligadas, 1/32");
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_all_tracks_16_steps_sixteenths);
+  RUN_TEST(test_mixed_lengths_and_resolutions);
+  RUN_TEST(test_half_the_tracks_muted);
+  return UNITY_END();
+}
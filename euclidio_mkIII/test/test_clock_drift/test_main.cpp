@@ -0,0 +1,99 @@
+// Benchmark no host: uma hora simulada do MidiClock em MASTER, medindo a
+// deriva acumulada de cada tick face à linha temporal ideal. O acumulador
+// fracionário (Bresenham) tem de ficar a menos de 1µs do ideal; o período
+// inteiro truncado usado antes é calculado ao lado para comparação.
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "MidiClock.h"
+
+MidiClock midiClock;
+
+static const double ONE_HOUR_US = 3600.0 * 1000000.0;
+
+static uint32_t ticksSeen;
+static uint32_t startUs;
+static double idealPeriodUs;
+static double maxDriftUs;
+static double lastDriftUs;
+
+static void onTick() {
+  ticksSeen++;
+  double ideal = startUs + ticksSeen * idealPeriodUs;
+  double drift = (double)midiClock.getEventTime() - ideal;
+  if (fabs(drift) > maxDriftUs) maxDriftUs = fabs(drift);
+  lastDriftUs = drift;
+}
+
+// Corre uma hora a `bpm` e devolve o número de ticks gerados
+static uint32_t runOneHour(float bpm, MidiClock::ClockRate rate) {
+  hostsim::reset();
+  midiClock.setClockCallback(onTick);
+  midiClock.setOutputClockRate(0, rate);
+  midiClock.begin(bpm);
+
+  ticksSeen = 0;
+  maxDriftUs = 0.0;
+  lastDriftUs = 0.0;
+  // Período ideal do BPM pedido (resolução de 0.001 BPM, como na UI/OSC)
+  idealPeriodUs = 60000000.0 / (round(bpm * 1000.0) / 1000.0 * 24.0);
+  startUs = hostsim::nowUs();
+  midiClock.start();
+
+  const uint32_t endUs = startUs + (uint32_t)ONE_HOUR_US;
+  while (hostsim::nextAlarmUs() <= endUs) {   // uma hora cabe em micros() sem wrap
+    hostsim::advanceTo(hostsim::nextAlarmUs());
+    midiClock.processPendingRealTime();
+  }
+  midiClock.stop();
+  midiClock.processPendingRealTime();
+  midiClock.setOutputClockRate(0, MidiClock::RATE_X1);
+  return ticksSeen;
+}
+
+static void checkOneHour(float bpm, MidiClock::ClockRate rate, const char* label) {
+  uint32_t ticks = runOneHour(bpm, rate);
+
+  // Relógio antigo: período truncado ao µs, o erro soma-se em cada tick
+  double legacyPeriod = floor(1000000.0 / (bpm / 60.0 * 24.0));
+  double legacyDriftMs = ticks * (legacyPeriod - idealPeriodUs) / 1000.0;
+
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%.3f bpm%s: %u ticks numa hora, deriva final %.2fus, max %.2fus (período inteiro: %.1fms)",
+           bpm, label, (unsigned)ticks, lastDriftUs, maxDriftUs, legacyDriftMs);
+  TEST_MESSAGE(line);
+
+  // Número de ticks certo e cada tick a menos de 1µs (quantização do timer)
+  uint32_t expected = (uint32_t)floor(ONE_HOUR_US / idealPeriodUs);
+  TEST_ASSERT_UINT32_WITHIN(1, expected, ticks);
+  TEST_ASSERT_TRUE_MESSAGE(maxDriftUs <= 1.0, "deriva acumulada acima de 1us");
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_one_hour_drift_integer_bpm() {
+  checkOneHour(120.0f, MidiClock::RATE_X1, "");
+  checkOneHour(90.0f, MidiClock::RATE_X1, "");
+}
+
+void test_one_hour_drift_fractional_bpm() {
+  checkOneHour(97.5f, MidiClock::RATE_X1, "");
+  checkOneHour(133.333f, MidiClock::RATE_X1, "");
+  checkOneHour(87.654f, MidiClock::RATE_X1, "");
+}
+
+void test_one_hour_drift_with_half_tick_grid() {
+  // Saída x2: o timer dispara também a meio de cada tick
+  checkOneHour(133.333f, MidiClock::RATE_X2, " (saída x2)");
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_one_hour_drift_integer_bpm);
+  RUN_TEST(test_one_hour_drift_fractional_bpm);
+  RUN_TEST(test_one_hour_drift_with_half_tick_grid);
+  return UNITY_END();
+}
@@ -0,0 +1,146 @@
+// Teste no host das rampas de tempo do MidiClock: regista o instante de cada
+// tick (tal como sai no clock MIDI) e verifica que nenhum período sai do
+// envelope da rampa, que a sequência é monótona e que mudanças de BPM só
+// entram numa fronteira de tick.
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "MidiClock.h"
+
+MidiClock midiClock;
+
+static const uint32_t MAX_TICKS = 4096;
+static const double TOLERANCE_US = 1.5;   // quantização do timer (1µs) + BPM em milésimos
+
+static uint32_t tickTimes[MAX_TICKS];
+static uint32_t ticksSeen;
+
+static void onTick() {
+  if (ticksSeen < MAX_TICKS) tickTimes[ticksSeen] = midiClock.getEventTime();
+  ticksSeen++;
+}
+
+static double periodUs(double bpm) {
+  return 60000000.0 / (bpm * 24.0);
+}
+
+// Corre até `count` ticks no total, processando cada evento como a task do clock
+static void runTicks(uint32_t count) {
+  while (ticksSeen < count) {
+    hostsim::advanceTo(hostsim::nextAlarmUs());
+    midiClock.processPendingRealTime();
+  }
+}
+
+static void startClock(float bpm) {
+  hostsim::reset();
+  midiClock.stop();
+  midiClock.processPendingRealTime();
+  midiClock.setClockCallback(onTick);
+  midiClock.begin(bpm);
+  ticksSeen = 0;
+  midiClock.start();
+  // O tick 0 é o instante do Start: os intervalos contam a partir dele
+  midiClock.processPendingRealTime();
+  tickTimes[0] = hostsim::nowUs();
+  ticksSeen = 1;
+}
+
+// BPM no ponto `idx` (0..rampTicks) de uma rampa
+static double rampBpm(double from, double to, uint32_t idx, uint32_t rampTicks, MidiClock::TempoRampShape shape) {
+  if (idx >= rampTicks) return to;
+  double t = (double)idx / rampTicks;
+  if (shape == MidiClock::RAMP_EXPONENTIAL) return from * pow(to / from, t);
+  return from + (to - from) * t;
+}
+
+static void checkRamp(float from, float to, uint16_t beats, MidiClock::TempoRampShape shape, const char* label) {
+  const uint32_t leadTicks = 48;
+  const uint32_t rampTicks = (uint32_t)beats * 24;
+  startClock(from);
+  runTicks(leadTicks + 1);
+  // Rampa pedida com a task parada entre ticks (como OSC/encoder no loop)
+  uint32_t rampStart = midiClock.getTickCount();
+  TEST_ASSERT_TRUE(midiClock.startTempoRamp(to, beats, shape));
+  uint32_t total = leadTicks + rampTicks + 48;
+  TEST_ASSERT_LESS_THAN(MAX_TICKS, total);
+  runTicks(total + 1);
+  TEST_ASSERT_FALSE(midiClock.isTempoRamping());
+
+  double lo = fmin(periodUs(from), periodUs(to)) - TOLERANCE_US;
+  double hi = fmax(periodUs(from), periodUs(to)) + TOLERANCE_US;
+  bool speedUp = to > from;
+  double maxStepUs = 0.0;
+  uint32_t outside = 0, nonMonotonic = 0, offRamp = 0;
+
+  for (uint32_t n = 2; n <= total; ++n) {
+    double interval = (double)(tickTimes[n] - tickTimes[n - 1]);
+    double prev = (double)(tickTimes[n - 1] - tickTimes[n - 2]);
+    if (interval < lo || interval > hi) outside++;
+    if (speedUp ? interval > prev + TOLERANCE_US : interval < prev - TOLERANCE_US) nonMonotonic++;
+    if (fabs(interval - prev) > maxStepUs) maxStepUs = fabs(interval - prev);
+
+    // Envelope local: o período deste tick é o de um ponto da rampa entre o
+    // tick anterior e o atual (o período novo entra na fronteira seguinte)
+    int32_t j = (int32_t)(n - rampStart);
+    uint32_t a = j - 2 > 0 ? (uint32_t)(j - 2) : 0;
+    uint32_t b = j > 0 ? (uint32_t)j : 0;
+    double pa = periodUs(rampBpm(from, to, a, rampTicks, shape));
+    double pb = periodUs(rampBpm(from, to, b, rampTicks, shape));
+    if (interval < fmin(pa, pb) - TOLERANCE_US || interval > fmax(pa, pb) + TOLERANCE_US) offRamp++;
+  }
+
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%s %.1f -> %.1f bpm em %u beats: %u ticks, maior variação entre períodos %.1fus, fora do envelope %u",
+           label, from, to, beats, (unsigned)total, maxStepUs, (unsigned)(outside + offRamp));
+  TEST_MESSAGE(line);
+
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, outside, "período fora do envelope global da rampa");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, offRamp, "período fora do envelope local da rampa");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, nonMonotonic, "rampa não monótona");
+  // No fim, o tempo fica exatamente no destino
+  double last = (double)(tickTimes[total] - tickTimes[total - 1]);
+  TEST_ASSERT_FLOAT_WITHIN(TOLERANCE_US, periodUs(to), last);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_linear_ramp_up_stays_in_envelope() {
+  checkRamp(100.0f, 140.0f, 8, MidiClock::RAMP_LINEAR, "linear");
+}
+
+void test_linear_ramp_down_stays_in_envelope() {
+  checkRamp(128.0f, 72.5f, 16, MidiClock::RAMP_LINEAR, "linear");
+}
+
+void test_exponential_ramps_stay_in_envelope() {
+  checkRamp(90.0f, 180.0f, 32, MidiClock::RAMP_EXPONENTIAL, "exponencial");
+  checkRamp(174.0f, 87.0f, 4, MidiClock::RAMP_EXPONENTIAL, "exponencial");
+}
+
+void test_bpm_jump_takes_effect_on_tick_boundary() {
+  startClock(120.0f);
+  runTicks(25);
+  // setBPM a meio de um tick: o tick em curso mantém o período antigo
+  uint32_t lastTick = tickTimes[24];
+  uint32_t nextTick = hostsim::nextAlarmUs();
+  hostsim::advanceTo(lastTick + 7000);
+  midiClock.setBPM(60.0f);
+  runTicks(28);
+  TEST_ASSERT_EQUAL_UINT32(nextTick, tickTimes[25]);
+  TEST_ASSERT_UINT32_WITHIN(1, (uint32_t)periodUs(120.0), tickTimes[25] - tickTimes[24]);
+  TEST_ASSERT_UINT32_WITHIN(1, (uint32_t)periodUs(60.0), tickTimes[26] - tickTimes[25]);
+  TEST_ASSERT_UINT32_WITHIN(1, (uint32_t)periodUs(60.0), tickTimes[27] - tickTimes[26]);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_linear_ramp_up_stays_in_envelope);
+  RUN_TEST(test_linear_ramp_down_stays_in_envelope);
+  RUN_TEST(test_exponential_ramps_stay_in_envelope);
+  RUN_TEST(test_bpm_jump_takes_effect_on_tick_boundary);
+  return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// Teste no host do clock de saída em SLAVE: alimenta o MidiClock real com
+// clock externo com jitter (±2ms) e compara o jitter dos intervalos à entrada
+// com o dos ticks que saem (instante de cada 0xF8 enviado), em modo
+// regenerado e em modo eco.
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "MidiClock.h"
+
+MidiClock midiClock;
+
+static const uint8_t USB_INPUT = 4;   // entrada USB (ClockIO por omissão)
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static int32_t jitterUs(int32_t amplitude) {
+  return (int32_t)(nextRandom() % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+struct IntervalJitter {
+  uint32_t count = 0;
+  double sumSq = 0.0;
+  double maxAbs = 0.0;
+  double lastUs = -1.0;
+
+  void add(double atUs, double idealUs) {
+    if (lastUs >= 0.0) {
+      double dev = (atUs - lastUs) - idealUs;
+      if (fabs(dev) > maxAbs) maxAbs = fabs(dev);
+      sumSq += dev * dev;
+      count++;
+    }
+    lastUs = atUs;
+  }
+  double rms() const { return count ? sqrt(sumSq / count) : 0.0; }
+};
+
+static IntervalJitter outputJitter;
+static double idealPeriodUs;
+static uint32_t outputTicks;
+static uint32_t warmupClocks;
+static uint32_t clocksSent;
+
+static void onTick() {
+  outputTicks++;
+  // Só conta depois do lock (os primeiros ticks seguem o clock diretamente)
+  if (clocksSent > warmupClocks) outputJitter.add(midiClock.getEventTime(), idealPeriodUs);
+  else outputJitter.lastUs = midiClock.getEventTime();
+}
+
+// Deixa correr o timer interno até `t` e entrega um clock externo nesse instante
+static void deliverClockAt(uint32_t t) {
+  while (hostsim::timer().enabled && hostsim::nextAlarmUs() <= t) {
+    hostsim::advanceTo(hostsim::nextAlarmUs());
+    midiClock.processPendingRealTime();
+  }
+  hostsim::advanceTo(t);
+  midiClock.receiveExternalClock(USB_INPUT);
+  midiClock.processPendingRealTime();
+}
+
+struct RegenResult {
+  IntervalJitter input;
+  IntervalJitter output;
+  uint32_t sentClocks;
+  uint32_t droppedClocks;
+  uint32_t outputTicks;
+  bool locked;
+};
+
+static RegenResult runSlave(MidiClock::ClockOutMode mode, float bpm, uint32_t clocks,
+                            int32_t jitter, uint32_t dropEvery) {
+  RegenResult r = {};
+  hostsim::reset();
+  midiClock.stop();
+  midiClock.processPendingRealTime();
+  midiClock.setClockCallback(onTick);
+  midiClock.setClockOutMode(mode);
+  midiClock.begin(bpm);
+  midiClock.setSyncMode(MidiClock::SLAVE);
+  midiClock.start();
+  midiClock.processPendingRealTime();
+
+  outputJitter = IntervalJitter();
+  outputTicks = 0;
+  clocksSent = 0;
+  warmupClocks = 48;
+  idealPeriodUs = 60000000.0 / (bpm * 24.0);
+
+  const double startUs = 100000.0;
+  for (uint32_t k = 0; k < clocks; ++k) {
+    uint32_t t = (uint32_t)(startUs + k * idealPeriodUs + jitterUs(jitter));
+    if (dropEvery && k > warmupClocks && k % dropEvery == 0) {
+      r.droppedClocks++;
+      continue;
+    }
+    clocksSent++;
+    deliverClockAt(t);
+    if (clocksSent > warmupClocks) r.input.add(t, idealPeriodUs);
+  }
+  r.sentClocks = clocksSent;
+  r.output = outputJitter;
+  r.outputTicks = outputTicks;
+  r.locked = midiClock.isExternalLocked();
+  midiClock.setSyncMode(MidiClock::MASTER);
+  return r;
+}
+
+static void report(const char* name, const RegenResult& r) {
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%s: jitter entrada max %.0fus rms %.0fus -> saída max %.0fus rms %.0fus (%u clocks, %u ticks)",
+           name, r.input.maxAbs, r.input.rms(), r.output.maxAbs, r.output.rms(),
+           (unsigned)(r.sentClocks + r.droppedClocks), (unsigned)r.outputTicks);
+  TEST_MESSAGE(line);
+}
+
+void setUp() {
+  rngState = 0x9E3779B9u;
+}
+
+void tearDown() {}
+
+void test_regenerated_output_removes_input_jitter() {
+  RegenResult r = runSlave(MidiClock::CLOCK_OUT_REGEN, 120.0f, 24 * 128, 2000, 0);
+  report("regenerado, +-2ms", r);
+  TEST_ASSERT_TRUE(r.locked);
+  // Saída bem mais regular do que a entrada, sem perder nem inventar ticks
+  TEST_ASSERT_LESS_THAN(r.input.rms() / 2.0, r.output.rms());
+  TEST_ASSERT_LESS_THAN(r.input.maxAbs, r.output.maxAbs);
+  TEST_ASSERT_UINT32_WITHIN(3, r.sentClocks, r.outputTicks);
+}
+
+void test_echo_output_follows_input_jitter() {
+  RegenResult r = runSlave(MidiClock::CLOCK_OUT_ECHO, 120.0f, 24 * 128, 2000, 0);
+  report("eco, +-2ms", r);
+  // Em eco cada 0xF8 sai quando chega: o jitter passa tal e qual
+  TEST_ASSERT_EQUAL_UINT32(r.sentClocks, r.outputTicks);
+  TEST_ASSERT_FLOAT_WITHIN(1.0, r.input.rms(), r.output.rms());
+}
+
+void test_regenerated_output_fills_dropouts() {
+  RegenResult r = runSlave(MidiClock::CLOCK_OUT_REGEN, 97.5f, 24 * 128, 2000, 53);
+  report("regenerado, +-2ms, 1 clock perdido em 53", r);
+  TEST_ASSERT_TRUE(r.locked);
+  TEST_ASSERT_LESS_THAN(r.input.rms() / 2.0, r.output.rms());
+  // Os clocks perdidos saem na mesma, espaçados pelo tempo estimado
+  TEST_ASSERT_UINT32_WITHIN(3, r.sentClocks + r.droppedClocks, r.outputTicks);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_regenerated_output_removes_input_jitter);
+  RUN_TEST(test_echo_output_follows_input_jitter);
+  RUN_TEST(test_regenerated_output_fills_dropouts);
+  return UNITY_END();
+}
@@ -0,0 +1,201 @@
+// Testes de propriedades no host do EuclideanPatterns contra um Bjorklund de
+// referência (versão clássica com listas, como no artigo de Toussaint), para
+// todos os steps 1..64 e hits 0..steps de cada algoritmo.
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "EuclideanPatterns.h"
+
+typedef EuclideanPatterns EP;
+
+// Bjorklund de referência: bit i = hit no step i
+static uint64_t referenceBjorklund(uint8_t steps, uint8_t hits) {
+  if (hits == 0) return 0;
+  if (hits >= steps) return EP::lowMask(steps);
+  std::vector<std::vector<bool> > a(hits, std::vector<bool>(1, true));
+  std::vector<std::vector<bool> > b(steps - hits, std::vector<bool>(1, false));
+  while (b.size() > 1) {
+    size_t n = a.size() < b.size() ? a.size() : b.size();
+    std::vector<std::vector<bool> > joined;
+    for (size_t i = 0; i < n; ++i) {
+      std::vector<bool> g = a[i];
+      g.insert(g.end(), b[i].begin(), b[i].end());
+      joined.push_back(g);
+    }
+    std::vector<std::vector<bool> > rest;
+    if (a.size() > n) rest.assign(a.begin() + n, a.end());
+    else rest.assign(b.begin() + n, b.end());
+    a = joined;
+    b = rest;
+  }
+  uint64_t mask = 0;
+  uint8_t pos = 0;
+  for (const std::vector<bool>& g : a) for (bool bit : g) mask |= (uint64_t)bit << pos++;
+  for (const std::vector<bool>& g : b) for (bool bit : g) mask |= (uint64_t)bit << pos++;
+  return mask;
+}
+
+static uint8_t popcount(uint64_t m) {
+  return (uint8_t)__builtin_popcountll(m);
+}
+
+// Rotação de referência bit a bit (direita: o step i recebe o step i - offset)
+static uint64_t referenceRotate(uint64_t mask, uint8_t steps, uint8_t offset) {
+  uint64_t out = 0;
+  for (uint8_t i = 0; i < steps; ++i) {
+    uint8_t src = (uint8_t)((i + steps - offset % steps) % steps);
+    if ((mask >> src) & 1) out |= 1ULL << i;
+  }
+  return out;
+}
+
+// Maximamente uniforme: distâncias cíclicas entre hits consecutivos diferem no máximo 1
+static bool maximallyEven(uint64_t mask, uint8_t steps) {
+  uint8_t first = 0xFF, prev = 0, minGap = 0xFF, maxGap = 0;
+  for (uint8_t i = 0; i < steps; ++i) {
+    if (!((mask >> i) & 1)) continue;
+    if (first == 0xFF) {
+      first = i;
+    } else {
+      uint8_t gap = (uint8_t)(i - prev);
+      if (gap < minGap) minGap = gap;
+      if (gap > maxGap) maxGap = gap;
+    }
+    prev = i;
+  }
+  if (first == 0xFF) return true;
+  uint8_t wrap = (uint8_t)(steps - prev + first);
+  if (wrap < minGap) minGap = wrap;
+  if (wrap > maxGap) maxGap = wrap;
+  return maxGap - minGap <= 1;
+}
+
+// Verdadeiro se `mask` é uma rotação de `ref` (padrões de `steps` steps)
+static bool isRotationOf(uint64_t mask, uint64_t ref, uint8_t steps) {
+  for (uint8_t off = 0; off < steps; ++off) {
+    if (referenceRotate(ref, steps, off) == mask) return true;
+  }
+  return false;
+}
+
+static const char* algoName(uint8_t algo) {
+  return algo == EP::ALGO_BJORKLUND ? "bjorklund" : (algo == EP::ALGO_BRESENHAM ? "bresenham" : "ancorado");
+}
+
+static void fail(uint8_t algo, uint8_t steps, uint8_t hits, const char* what) {
+  char msg[120];
+  snprintf(msg, sizeof(msg), "%s s=%u h=%u: %s", algoName(algo), (unsigned)steps, (unsigned)hits, what);
+  TEST_MESSAGE(msg);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_bjorklund_matches_reference() {
+  uint32_t cases = 0, mismatches = 0;
+  for (uint8_t s = EP::MIN_STEPS; s <= EP::MAX_STEPS; ++s) {
+    for (uint8_t h = 0; h <= s; ++h) {
+      cases++;
+      if (EP::base(s, h, EP::ALGO_BJORKLUND) != referenceBjorklund(s, h)) {
+        if (mismatches++ < 8) fail(EP::ALGO_BJORKLUND, s, h, "diferente da referência");
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(EP::TABLE_SIZE, cases);
+  TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+void test_every_algorithm_is_a_rotation_of_reference() {
+  uint32_t failures = 0;
+  for (uint8_t algo = 0; algo < EP::ALGO_COUNT; ++algo) {
+    for (uint8_t s = EP::MIN_STEPS; s <= EP::MAX_STEPS; ++s) {
+      for (uint8_t h = 0; h <= s; ++h) {
+        uint64_t m = EP::base(s, h, (EP::Algorithm)algo);
+        uint64_t ref = referenceBjorklund(s, h);
+        const char* err = nullptr;
+        if (m & ~EP::lowMask(s)) err = "bits acima de steps";
+        else if (popcount(m) != h) err = "número de hits errado";
+        else if (!maximallyEven(m, s)) err = "não é maximamente uniforme";
+        else if (!isRotationOf(m, ref, s)) err = "não é rotação do Bjorklund de referência";
+        if (err) {
+          if (failures++ < 8) fail(algo, s, h, err);
+        }
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, failures);
+}
+
+void test_anchors_of_each_algorithm() {
+  for (uint8_t s = EP::MIN_STEPS; s <= EP::MAX_STEPS; ++s) {
+    for (uint8_t h = 1; h <= s; ++h) {
+      // Ancorado e Bjorklund começam num hit; Bresenham acaba num hit
+      TEST_ASSERT_TRUE(EP::base(s, h, EP::ALGO_ANCHORED) & 1);
+      TEST_ASSERT_TRUE(EP::base(s, h, EP::ALGO_BJORKLUND) & 1);
+      TEST_ASSERT_TRUE((EP::base(s, h, EP::ALGO_BRESENHAM) >> (s - 1)) & 1);
+      // Ancorado é a regra (i*hits)%steps < hits usada antes da tabela
+      uint64_t rule = 0;
+      for (uint8_t i = 0; i < s; ++i) {
+        if ((((uint16_t)i * h) % s) < h) rule |= 1ULL << i;
+      }
+      TEST_ASSERT_TRUE(EP::base(s, h, EP::ALGO_ANCHORED) == rule);
+    }
+  }
+}
+
+void test_known_rhythms() {
+  // E(3,8) tresillo, E(5,8) cinquillo, E(2,5), E(7,16) (Toussaint)
+  TEST_ASSERT_TRUE(EP::base(8, 3, EP::ALGO_BJORKLUND) == 0x49ULL);     // x..x..x.
+  TEST_ASSERT_TRUE(EP::base(8, 5, EP::ALGO_BJORKLUND) == 0x6DULL);     // x.xx.xx.
+  TEST_ASSERT_TRUE(EP::base(5, 2, EP::ALGO_BJORKLUND) == 0x05ULL);     // x.x..
+  TEST_ASSERT_EQUAL_UINT8(7, popcount(EP::base(16, 7, EP::ALGO_BJORKLUND)));
+  TEST_ASSERT_TRUE(EP::base(16, 7, EP::ALGO_BJORKLUND) == referenceBjorklund(16, 7));
+}
+
+void test_rotation_and_offsets() {
+  for (uint8_t algo = 0; algo < EP::ALGO_COUNT; ++algo) {
+    for (uint8_t s = EP::MIN_STEPS; s <= EP::MAX_STEPS; ++s) {
+      for (uint8_t h = 0; h <= s; h = (uint8_t)(h + 1 + s / 8)) {
+        uint64_t base = EP::base(s, h, (EP::Algorithm)algo);
+        for (uint16_t off = 0; off < 2u * s + 3; off = (uint16_t)(off + 1 + s / 16)) {
+          uint64_t got = EP::get(s, h, (uint8_t)off, (EP::Algorithm)algo);
+          if (got != referenceRotate(base, s, (uint8_t)off)) {
+            fail(algo, s, h, "offset diferente da rotação de referência");
+            TEST_FAIL_MESSAGE("rotação");
+          }
+        }
+        // Rodar `steps` vezes volta ao início
+        TEST_ASSERT_TRUE(EP::rotate(base, s, s) == base);
+      }
+    }
+  }
+}
+
+void test_limits_are_shared_and_clamped() {
+  TEST_ASSERT_EQUAL_UINT8(1, EP::clampSteps(0));
+  TEST_ASSERT_EQUAL_UINT8(1, EP::clampSteps(-5));
+  TEST_ASSERT_EQUAL_UINT8(64, EP::clampSteps(64));
+  TEST_ASSERT_EQUAL_UINT8(64, EP::clampSteps(200));
+  TEST_ASSERT_EQUAL_UINT8(1, EP::clampHits(0));
+  TEST_ASSERT_EQUAL_UINT8(64, EP::clampHits(99));
+  TEST_ASSERT_EQUAL_INT(EP::ALGO_ANCHORED, EP::clampAlgorithm(-1));
+  TEST_ASSERT_EQUAL_INT(EP::ALGO_ANCHORED, EP::clampAlgorithm(EP::ALGO_COUNT));
+  TEST_ASSERT_EQUAL_INT(EP::ALGO_BRESENHAM, EP::clampAlgorithm(EP::ALGO_BRESENHAM));
+  // Fora dos limites: hits > steps dá todos os steps, steps acima de 64 limitado
+  TEST_ASSERT_TRUE(EP::base(12, 20) == EP::lowMask(12));
+  TEST_ASSERT_TRUE(EP::base(0, 3) == 0);
+  TEST_ASSERT_TRUE(EP::base(100, 64) == ~0ULL);
+  TEST_ASSERT_TRUE(EP::get(100, 5, 0) == EP::base(64, 5));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bjorklund_matches_reference);
+  RUN_TEST(test_every_algorithm_is_a_rotation_of_reference);
+  RUN_TEST(test_anchors_of_each_algorithm);
+  RUN_TEST(test_known_rhythms);
+  RUN_TEST(test_rotation_and_offsets);
+  RUN_TEST(test_limits_are_shared_and_clamped);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+// Stress multithread no host da MpscQueue: vários produtores (std::thread)
+// publicam eventos numerados por produtor enquanto um consumidor os retira.
+// Prova que nenhum evento se perde nem se duplica, que a ordem de cada
+// produtor se mantém e que nenhum evento chega corrompido (escrita rasgada).
+#include <unity.h>
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "MpscQueue.h"
+
+struct StressEvent {
+  uint8_t producer;
+  uint32_t seq;
+  uint32_t check;    // derivado de producer/seq: deteta células lidas a meio
+  uint8_t payload[6];
+};
+
+static uint32_t checksum(uint8_t producer, uint32_t seq) {
+  uint32_t x = seq * 2654435761u ^ ((uint32_t)producer << 24);
+  x ^= x >> 15;
+  return x * 2246822519u;
+}
+
+struct StressResult {
+  uint64_t received = 0;
+  uint64_t lost = 0;
+  uint64_t duplicated = 0;
+  uint64_t reordered = 0;
+  uint64_t corrupted = 0;
+  uint64_t fullRetries = 0;
+};
+
+template <uint16_t N>
+static StressResult runStress(uint8_t producers, uint32_t perProducer) {
+  MpscQueue<StressEvent, N>* queue = new MpscQueue<StressEvent, N>();
+
+  StressResult r;
+  std::atomic<uint64_t> fullRetries(0);
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+
+  for (uint8_t p = 0; p < producers; ++p) {
+    threads.emplace_back([p, perProducer, queue, &go, &fullRetries]() {
+      while (!go.load(std::memory_order_acquire)) {}
+      uint64_t retries = 0;
+      for (uint32_t s = 0; s < perProducer; ++s) {
+        StressEvent e;
+        e.producer = p;
+        e.seq = s;
+        e.check = checksum(p, s);
+        for (uint8_t i = 0; i < sizeof(e.payload); ++i) e.payload[i] = (uint8_t)(e.check >> (i * 4));
+        // Fila cheia: o produtor volta a tentar (o engine conta e descarta)
+        while (!queue->push(e)) {
+          retries++;
+          std::this_thread::yield();
+        }
+      }
+      fullRetries += retries;
+    });
+  }
+
+  std::vector<uint32_t> nextSeq(producers, 0);
+  std::vector<uint32_t> count(producers, 0);
+  const uint64_t total = (uint64_t)producers * perProducer;
+  go.store(true, std::memory_order_release);
+
+  StressEvent e;
+  while (r.received < total) {
+    if (!queue->pop(e)) {
+      std::this_thread::yield();
+      continue;
+    }
+    r.received++;
+    bool intact = e.producer < producers && e.check == checksum(e.producer, e.seq);
+    for (uint8_t i = 0; intact && i < sizeof(e.payload); ++i) {
+      intact = e.payload[i] == (uint8_t)(e.check >> (i * 4));
+    }
+    if (!intact) {
+      r.corrupted++;
+      continue;
+    }
+    if (e.seq < nextSeq[e.producer]) r.duplicated++;
+    else if (e.seq > nextSeq[e.producer]) r.reordered++;
+    if (e.seq >= nextSeq[e.producer]) nextSeq[e.producer] = e.seq + 1;
+    count[e.producer]++;
+  }
+  for (std::thread& t : threads) t.join();
+
+  // Nada pode ficar para trás depois de todos os produtores terminarem
+  while (queue->pop(e)) r.duplicated++;
+  for (uint8_t p = 0; p < producers; ++p) {
+    if (count[p] < perProducer) r.lost += perProducer - count[p];
+  }
+  r.fullRetries = fullRetries.load();
+  delete queue;
+  return r;
+}
+
+static void report(const char* name, uint8_t producers, uint32_t perProducer, const StressResult& r) {
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%s: %u produtores x %u eventos, recebidos %llu, perdidos %llu, duplicados %llu, fora de ordem %llu, corrompidos %llu, fila cheia %llu vezes",
+           name, (unsigned)producers, (unsigned)perProducer, (unsigned long long)r.received,
+           (unsigned long long)r.lost, (unsigned long long)r.duplicated, (unsigned long long)r.reordered,
+           (unsigned long long)r.corrupted, (unsigned long long)r.fullRetries);
+  TEST_MESSAGE(line);
+}
+
+static void checkResult(uint8_t producers, uint32_t perProducer, const StressResult& r) {
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE((uint64_t)producers * perProducer, r.received, "total recebido diferente do enviado");
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.lost, "eventos perdidos");
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.duplicated, "eventos duplicados");
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.reordered, "ordem de um produtor trocada");
+  TEST_ASSERT_EQUAL_UINT64_MESSAGE(0, r.corrupted, "eventos corrompidos");
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_three_producers_midi_queue_size() {
+  // Como o engine: clock task, loop principal e sequenciador harmónico
+  const uint8_t producers = 3;
+  const uint32_t perProducer = 200000;
+  StressResult r = runStress<128>(producers, perProducer);
+  report("N=128", producers, perProducer, r);
+  checkResult(producers, perProducer, r);
+}
+
+void test_many_producers_small_ring() {
+  // Fila pequena: muitas voltas ao ring e produtores a competir por células
+  const uint8_t producers = 8;
+  const uint32_t perProducer = 100000;
+  StressResult r = runStress<8>(producers, perProducer);
+  report("N=8", producers, perProducer, r);
+  checkResult(producers, perProducer, r);
+  TEST_ASSERT_GREATER_THAN(0, r.fullRetries);
+}
+
+void test_single_thread_full_and_front() {
+  MpscQueue<StressEvent, 4> q;
+  StressEvent e = {};
+  TEST_ASSERT_TRUE(q.empty());
+  TEST_ASSERT_TRUE(q.front() == nullptr);
+  for (uint32_t s = 0; s < 4; ++s) {
+    e.seq = s;
+    TEST_ASSERT_TRUE(q.push(e));
+  }
+  TEST_ASSERT_FALSE(q.push(e));
+  TEST_ASSERT_EQUAL_UINT32(4, q.size());
+  TEST_ASSERT_EQUAL_UINT32(0, q.front()->seq);
+  for (uint32_t s = 0; s < 4; ++s) {
+    TEST_ASSERT_TRUE(q.pop(e));
+    TEST_ASSERT_EQUAL_UINT32(s, e.seq);
+  }
+  TEST_ASSERT_FALSE(q.pop(e));
+  TEST_ASSERT_TRUE(q.empty());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_thread_full_and_front);
+  RUN_TEST(test_three_producers_midi_queue_size);
+  RUN_TEST(test_many_producers_small_ring);
+  return UNITY_END();
+}
@@ -0,0 +1,260 @@
+// Teste no host do TempoTracker: clock externo com jitter (±2ms), clocks
+// perdidos e duplicados. Um gerador modelado como o do MidiClock em SLAVE
+// (período corrigido em fase, adotado na fronteira do tick seguinte) produz
+// os ticks internos; o relatório compara o jitter de passo (1/16 = 6 ticks)
+// à entrada com o dos passos gerados.
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "TempoTracker.h"
+
+static const uint8_t TICKS_PER_STEP = 6;
+static const uint8_t FREEWHEEL_TICKS = 3;   // como MidiClock::SLAVE_FREEWHEEL_TICKS
+static const float RESYNC_TICKS = 2.0f;     // como MidiClock::SLAVE_RESYNC_TICKS
+
+// PRNG determinístico (xorshift32) para o jitter
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static int32_t jitterUs(int32_t amplitude) {
+  return (int32_t)(nextRandom() % (uint32_t)(2 * amplitude + 1)) - amplitude;
+}
+
+struct StepJitter {
+  uint32_t steps = 0;
+  double sumSq = 0.0;
+  double maxAbs = 0.0;
+
+  // Desvio do intervalo entre passos face ao ideal
+  void add(double intervalUs, double idealUs) {
+    double dev = intervalUs - idealUs;
+    if (fabs(dev) > maxAbs) maxAbs = fabs(dev);
+    sumSq += dev * dev;
+    steps++;
+  }
+  double rms() const { return steps ? sqrt(sumSq / steps) : 0.0; }
+};
+
+// Gerador de ticks internos que segue o TempoTracker
+struct TrackedGenerator {
+  TempoTracker tracker;
+  bool running = false;
+  uint32_t extTicks = 0;
+  uint32_t genTicks = 0;
+  double lastGenUs = 0.0;
+  double nextGenUs = 0.0;
+  double pendingPeriodUs = 0.0;
+  double lastStepUs = -1.0;
+  double idealStepUs = 0.0;
+  StepJitter jitter;
+  double bpmSum = 0.0;       // média da estimativa com lock (a instantânea oscila com o jitter)
+  uint32_t bpmSamples = 0;
+
+  // Gera os ticks internos devidos até `untilUs` (exclusivo)
+  void runUntil(double untilUs) {
+    while (running && nextGenUs < untilUs) {
+      if (genTicks >= extTicks + FREEWHEEL_TICKS) {
+        running = false;
+        break;
+      }
+      emitTick(nextGenUs);
+      nextGenUs += pendingPeriodUs;
+    }
+  }
+
+  void emitTick(double atUs) {
+    genTicks++;
+    lastGenUs = atUs;
+    if (genTicks % TICKS_PER_STEP == 0) {
+      if (lastStepUs >= 0.0) jitter.add(atUs - lastStepUs, idealStepUs);
+      lastStepUs = atUs;
+    }
+  }
+
+  void onClock(uint32_t nowUs) {
+    runUntil(nowUs);
+    uint8_t ticks = tracker.onClock(nowUs);
+    if (ticks == 0) return;
+    extTicks += ticks;
+    if (tracker.isLocked()) {
+      bpmSum += tracker.getBPM();
+      bpmSamples++;
+    }
+
+    if (!tracker.isLocked() || !running) {
+      // Sem lock (ou ainda parado): ticks seguem diretamente os clocks
+      while (genTicks < extTicks) emitTick(nowUs);
+      if (tracker.isLocked()) {
+        running = true;
+        pendingPeriodUs = tracker.getPeriodUs();
+        nextGenUs = nowUs + pendingPeriodUs;
+      }
+      return;
+    }
+
+    double frac = (nowUs - lastGenUs) / tracker.getPeriodUs();
+    if (frac > 1.0) frac = 1.0;
+    float phaseError = (float)((double)(int32_t)(extTicks - genTicks) - frac);
+    if (phaseError > RESYNC_TICKS) {
+      while (genTicks < extTicks) emitTick(nowUs);
+      nextGenUs = nowUs + tracker.getPeriodUs();
+      phaseError = 0.0f;
+    }
+    // O tick já armado mantém o seu período; o novo vale a partir do seguinte
+    pendingPeriodUs = tracker.correctedPeriodUs(phaseError);
+  }
+};
+
+struct StreamResult {
+  StepJitter input;
+  StepJitter output;
+  uint32_t sentClocks;
+  uint32_t droppedClocks;
+  uint32_t doubledClocks;
+  uint32_t genTicks;
+  uint32_t missingDetected;
+  uint32_t doubledDetected;
+  float bpmEstimate;
+  bool locked;
+};
+
+// Fluxo de `clocks` clocks a `bpm`, com jitter uniforme ±`jitter` µs.
+// A cada `dropEvery` clocks perde um; a cada `doubleEvery` duplica um (0 = nunca).
+static StreamResult runStream(float bpm, uint32_t clocks, int32_t jitter,
+                              uint32_t dropEvery, uint32_t doubleEvery) {
+  StreamResult r = {};
+  TrackedGenerator gen;
+  double periodUs = 60000000.0 / (bpm * TempoTracker::PPQN);
+  gen.idealStepUs = periodUs * TICKS_PER_STEP;
+
+  const double startUs = 100000.0;
+  double lastInputStepUs = -1.0;
+  for (uint32_t k = 0; k < clocks; ++k) {
+    double ideal = startUs + k * periodUs;
+    // Passo de entrada: instante (com jitter) em que o clock chega ou chegaria
+    uint32_t t = (uint32_t)(ideal + jitterUs(jitter));
+    if ((k + 1) % TICKS_PER_STEP == 0) {
+      if (lastInputStepUs >= 0.0) r.input.add(t - lastInputStepUs, gen.idealStepUs);
+      lastInputStepUs = t;
+    }
+
+    if (dropEvery && k > 0 && k % dropEvery == 0) {
+      r.droppedClocks++;
+      continue;
+    }
+    gen.onClock(t);
+    r.sentClocks++;
+    if (doubleEvery && k > 0 && k % doubleEvery == 0) {
+      gen.onClock(t + 700);
+      r.doubledClocks++;
+    }
+  }
+  gen.runUntil(startUs + clocks * periodUs);
+
+  r.output = gen.jitter;
+  r.genTicks = gen.genTicks;
+  r.missingDetected = gen.tracker.getMissingClocks();
+  r.doubledDetected = gen.tracker.getDoubledClocks();
+  r.bpmEstimate = gen.bpmSamples ? (float)(gen.bpmSum / gen.bpmSamples) : 0.0f;
+  r.locked = gen.tracker.isLocked();
+  return r;
+}
+
+static void report(const char* name, const StreamResult& r) {
+  char line[200];
+  snprintf(line, sizeof(line),
+           "%s: jitter de passo entrada max %.0fus rms %.0fus -> gerado max %.0fus rms %.0fus (bpm médio %.2f)",
+           name, r.input.maxAbs, r.input.rms(), r.output.maxAbs, r.output.rms(), r.bpmEstimate);
+  TEST_MESSAGE(line);
+}
+
+void setUp() {
+  rngState = 0x2545F491u;
+}
+
+void tearDown() {}
+
+void test_clean_clock_locks_to_tempo() {
+  StreamResult r = runStream(120.0f, 24 * 64, 0, 0, 0);
+  report("sem jitter", r);
+  TEST_ASSERT_TRUE(r.locked);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 120.0f, r.bpmEstimate);
+  TEST_ASSERT_LESS_THAN(50.0, r.output.maxAbs);
+}
+
+void test_jittered_clock_is_smoothed() {
+  StreamResult r = runStream(120.0f, 24 * 256, 2000, 0, 0);
+  report("jitter +-2ms", r);
+  TEST_ASSERT_TRUE(r.locked);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 120.0f, r.bpmEstimate);
+  // Os passos gerados têm de ser bem mais regulares do que os clocks recebidos
+  TEST_ASSERT_LESS_THAN(r.input.rms() / 2.0, r.output.rms());
+  TEST_ASSERT_LESS_THAN(r.input.maxAbs, r.output.maxAbs);
+  // Sem ticks perdidos nem a mais: o gerador acompanha a fonte
+  TEST_ASSERT_UINT32_WITHIN(FREEWHEEL_TICKS, r.sentClocks, r.genTicks);
+}
+
+void test_jittered_clock_at_other_tempos() {
+  const float tempos[] = {60.0f, 97.5f, 174.0f};
+  for (float bpm : tempos) {
+    StreamResult r = runStream(bpm, 24 * 128, 2000, 0, 0);
+    char name[32];
+    snprintf(name, sizeof(name), "jitter +-2ms a %.1f bpm", bpm);
+    report(name, r);
+    TEST_ASSERT_TRUE(r.locked);
+    TEST_ASSERT_FLOAT_WITHIN(bpm * 0.005f, bpm, r.bpmEstimate);
+    TEST_ASSERT_LESS_THAN(r.input.rms() / 2.0, r.output.rms());
+  }
+}
+
+void test_dropouts_are_counted_and_filled() {
+  // Perde 1 clock em cada 37, com jitter
+  StreamResult r = runStream(120.0f, 24 * 256, 2000, 37, 0);
+  report("jitter +-2ms, 1 clock perdido em 37", r);
+  TEST_ASSERT_TRUE(r.locked);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 120.0f, r.bpmEstimate);
+  // Os clocks perdidos depois do lock são detetados e os ticks repostos
+  TEST_ASSERT_UINT32_WITHIN(2, r.droppedClocks, r.missingDetected);
+  TEST_ASSERT_UINT32_WITHIN(FREEWHEEL_TICKS, r.sentClocks + r.droppedClocks, r.genTicks);
+  TEST_ASSERT_LESS_THAN(r.input.rms() / 2.0, r.output.rms());
+}
+
+void test_doubled_clocks_are_ignored() {
+  StreamResult r = runStream(120.0f, 24 * 256, 2000, 0, 41);
+  report("jitter +-2ms, 1 clock duplicado em 41", r);
+  TEST_ASSERT_TRUE(r.locked);
+  TEST_ASSERT_UINT32_WITHIN(1, r.doubledClocks, r.doubledDetected);
+  TEST_ASSERT_UINT32_WITHIN(FREEWHEEL_TICKS, r.sentClocks, r.genTicks);
+  TEST_ASSERT_LESS_THAN(r.input.rms() / 2.0, r.output.rms());
+}
+
+void test_long_gap_restarts_acquisition() {
+  TempoTracker tracker;
+  const uint32_t periodUs = 20833;
+  uint32_t t = 0;
+  for (int i = 0; i < 48; ++i) tracker.onClock(t += periodUs);
+  TEST_ASSERT_TRUE(tracker.isLocked());
+  // Fonte parada durante 10 períodos: não conta como clocks perdidos
+  TEST_ASSERT_EQUAL_UINT8(1, tracker.onClock(t += 10 * periodUs));
+  TEST_ASSERT_FALSE(tracker.isLocked());
+  TEST_ASSERT_EQUAL_UINT32(0, tracker.getMissingClocks());
+  for (int i = 0; i < 12; ++i) tracker.onClock(t += periodUs);
+  TEST_ASSERT_TRUE(tracker.isLocked());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_clock_locks_to_tempo);
+  RUN_TEST(test_jittered_clock_is_smoothed);
+  RUN_TEST(test_jittered_clock_at_other_tempos);
+  RUN_TEST(test_dropouts_are_counted_and_filled);
+  RUN_TEST(test_doubled_clocks_are_ignored);
+  RUN_TEST(test_long_gap_restarts_acquisition);
+  return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// Stress/benchmark no host da TimingWheel: todas as tracks (Euclidean e
+// harmónicas) a 1/32 com acordes de 5 vozes, gates do staccato a notas longas
+// que atravessam vários steps. Verifica que cada Note Off sai exatamente uma
+// vez, nunca antes do prazo e dentro da resolução da roda, e mede o custo de
+// agendar/expirar.
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "TimingWheel.h"
+
+static const uint8_t EUCLID_TRACK_COUNT = EUCLID_TRACKS;
+static const uint8_t HARMONIC_TRACK_COUNT = 8;   // EuclideanHarmonicSequencer::MAX_TRACKS
+static const uint8_t CHORD_VOICES = 5;
+static const uint16_t OUT_BATCH = 32;            // como NOTE_OFF_BATCH do engine
+
+static TimingWheel wheel;   // ~16KB: fora da stack
+
+static uint32_t rngState;
+
+static uint32_t nextRandom() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+struct StressResult {
+  uint32_t scheduled = 0;
+  uint32_t expired = 0;
+  uint32_t duplicates = 0;
+  uint32_t missing = 0;
+  int32_t minErrorUs = 0;
+  int32_t maxErrorUs = 0;
+  uint16_t peak = 0;
+  uint32_t dropped = 0;
+  double scheduleNs = 0.0;
+  double advanceNs = 0.0;
+};
+
+// Simula `seconds` segundos a `bpm`, com o worker a chamar advance() a cada
+// `pollUs` µs. Gates: 60% até 1 step, 30% até 4 steps, 10% de 0.5 a 3s.
+static StressResult runStress(float bpm, uint32_t seconds, uint32_t pollUs) {
+  typedef std::chrono::steady_clock Clock;
+  StressResult r;
+  rngState = 0x1234567u;
+
+  const uint32_t stepUs = (uint32_t)(60000000.0 / (bpm * 24.0) * 3.0);   // 1/32 = 3 ticks
+  const uint32_t tracks = EUCLID_TRACK_COUNT + HARMONIC_TRACK_COUNT;
+  const uint32_t endUs = seconds * 1000000UL;
+  const uint32_t startUs = 0xFFFFFFFFu - 5000000UL;   // atravessa o wrap de micros()
+
+  std::vector<uint32_t> dueUs;
+  std::vector<uint8_t> seen;
+  dueUs.reserve((size_t)(endUs / stepUs + 1) * tracks * CHORD_VOICES);
+
+  wheel.reset(startUs);
+  uint32_t out[OUT_BATCH];
+  Clock::duration scheduleTime(0), advanceTime(0);
+  uint32_t advanceCalls = 0;
+  bool first = true;
+
+  auto drain = [&](uint32_t now) {
+    uint16_t n;
+    do {
+      Clock::time_point t0 = Clock::now();
+      n = wheel.advance(now, out, OUT_BATCH);
+      advanceTime += Clock::now() - t0;
+      advanceCalls++;
+      for (uint16_t i = 0; i < n; ++i) {
+        uint32_t id = out[i];
+        if (seen[id]) {
+          r.duplicates++;
+          continue;
+        }
+        seen[id] = 1;
+        r.expired++;
+        int32_t err = (int32_t)(now - dueUs[id]);
+        if (first || err < r.minErrorUs) r.minErrorUs = err;
+        if (first || err > r.maxErrorUs) r.maxErrorUs = err;
+        first = false;
+      }
+    } while (n == OUT_BATCH);
+  };
+
+  uint32_t nextStep = 0;
+  for (uint32_t t = 0; t <= endUs + 3000000UL; t += pollUs) {
+    uint32_t now = startUs + t;
+    // Steps devidos neste intervalo: todas as tracks disparam acordes completos
+    while (t <= endUs && nextStep <= t) {
+      uint32_t stepNow = startUs + nextStep;
+      for (uint32_t track = 0; track < tracks; ++track) {
+        for (uint8_t v = 0; v < CHORD_VOICES; ++v) {
+          uint32_t roll = nextRandom() % 100;
+          uint32_t gate;
+          if (roll < 60) gate = 500 + nextRandom() % stepUs;
+          else if (roll < 90) gate = stepUs + nextRandom() % (3 * stepUs);
+          else gate = 500000 + nextRandom() % 2500000;
+          uint32_t id = (uint32_t)dueUs.size();
+          dueUs.push_back(stepNow + gate);
+          seen.push_back(0);
+          Clock::time_point t0 = Clock::now();
+          bool ok = wheel.schedule(stepNow, gate, id);
+          scheduleTime += Clock::now() - t0;
+          if (ok) r.scheduled++;
+        }
+      }
+      nextStep += stepUs;
+    }
+    drain(now);
+  }
+
+  for (size_t id = 0; id < seen.size(); ++id) {
+    if (!seen[id]) r.missing++;
+  }
+  r.peak = wheel.getPeakSize();
+  r.dropped = wheel.getDroppedEvents();
+  r.scheduleNs = r.scheduled ? std::chrono::duration<double, std::nano>(scheduleTime).count() / r.scheduled : 0.0;
+  r.advanceNs = advanceCalls ? std::chrono::duration<double, std::nano>(advanceTime).count() / advanceCalls : 0.0;
+  return r;
+}
+
+static void report(const char* name, const StressResult& r) {
+  char line[240];
+  snprintf(line, sizeof(line),
+           "%s: %u notas, pico %u pendentes, erro %d..%dus, schedule %.0fns/nota, advance %.0fns/chamada",
+           name, (unsigned)r.scheduled, (unsigned)r.peak, (int)r.minErrorUs, (int)r.maxErrorUs,
+           r.scheduleNs, r.advanceNs);
+  TEST_MESSAGE(line);
+}
+
+static void checkStress(const StressResult& r, uint32_t pollUs) {
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, r.dropped, "pool da roda esgotado");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, r.duplicates, "Note Off duplicado");
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, r.missing, "Note Off perdido");
+  TEST_ASSERT_EQUAL_UINT32(r.scheduled, r.expired);
+  TEST_ASSERT_TRUE(wheel.empty());
+  // Resolução da roda: nunca antes do prazo, no máximo um tick + um poll depois
+  TEST_ASSERT_GREATER_OR_EQUAL(0, r.minErrorUs);
+  TEST_ASSERT_LESS_THAN((int32_t)(TimingWheel::TICK_US + pollUs), r.maxErrorUs);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_all_tracks_1_32_five_voice_chords_rtos_tick() {
+  // Worker acordado a cada tick do RTOS (1ms)
+  StressResult r = runStress(180.0f, 60, 1000);
+  report("180 bpm, poll 1ms", r);
+  checkStress(r, 1000);
+  TEST_ASSERT_GREATER_THAN(1000, r.peak);
+}
+
+void test_all_tracks_1_32_five_voice_chords_sub_ms() {
+  // Com polls de 100µs o erro fica abaixo de meio milissegundo
+  StressResult r = runStress(140.0f, 20, 100);
+  report("140 bpm, poll 100us", r);
+  checkStress(r, 100);
+  TEST_ASSERT_LESS_THAN(500, r.maxErrorUs);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_all_tracks_1_32_five_voice_chords_rtos_tick);
+  RUN_TEST(test_all_tracks_1_32_five_voice_chords_sub_ms);
+  return UNITY_END();
+}